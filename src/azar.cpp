@@ -0,0 +1,72 @@
+/*
+--------------------------------------------------------------
+ azar.cpp
+
+ Implementación de la clase Azar (xoshiro128**, de Blackman y
+ Vigna). La semilla se expande con splitmix64, que evita estados
+ con todos los bits en cero y separa bien semillas parecidas.
+--------------------------------------------------------------
+*/
+
+#include "azar.h"
+
+static inline uint32_t rotar(uint32_t x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+static uint64_t splitmix64(uint64_t& x) {
+	uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+void Azar::sembrar(uint64_t semilla)
+{
+	uint64_t a = splitmix64(semilla);
+	uint64_t b = splitmix64(semilla);
+	s[0] = (uint32_t)a;
+	s[1] = (uint32_t)(a >> 32);
+	s[2] = (uint32_t)b;
+	s[3] = (uint32_t)(b >> 32);
+}
+
+// El número de flujo se mezcla con la semilla antes de sembrar,
+// así los flujos 0, 1, 2... no se parecen entre sí.
+Azar Azar::flujo(uint64_t semillaSesion, uint64_t n)
+{
+	uint64_t x = semillaSesion ^ (n * 0xD1B54A32D192ED03ull);
+	return Azar(splitmix64(x));
+}
+
+uint32_t Azar::siguiente()
+{
+	uint32_t resultado = rotar(s[1] * 5, 7) * 9;
+	uint32_t t = s[1] << 9;
+	
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotar(s[3], 11);
+	
+	return resultado;
+}
+
+void Azar::llenarUniforme(float* destino, int cantidad, float min, float max)
+{
+	float escala = (max - min) * (1.0f / 16777216.0f);
+	for(int i = 0; i < cantidad; i++)
+		destino[i] = min + (siguiente() >> 8) * escala;
+}
+
+void Azar::getEstado(uint32_t estado[4]) const
+{
+	for(int i = 0; i < 4; i++) estado[i] = s[i];
+}
+
+void Azar::setEstado(const uint32_t estado[4])
+{
+	for(int i = 0; i < 4; i++) s[i] = estado[i];
+}
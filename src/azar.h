@@ -0,0 +1,52 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ azar.h
+
+ Clase Azar
+
+ Generador de números pseudoaleatorios chico y rápido
+ (xoshiro128**), para reemplazar a ofRandom en la simulación:
+
+   - Cada Azar tiene su propio estado (16 bytes), así que no hay
+     estado global compartido: se puede usar uno por hilo o uno por
+     generación de pelotas sin bloqueos.
+   - Todo sale de una sola "semilla de sesión". Azar::flujo(semilla, n)
+     deriva el flujo número n, independiente de los demás. Con la
+     misma semilla se repite exactamente la misma función.
+   - llenarUniforme() llena un arreglo entero de una vez.
+--------------------------------------------------------------
+*/
+
+class Azar
+{
+public:
+	Azar(uint64_t semilla = 1) { sembrar(semilla); }
+	
+	// Reinicia el estado a partir de una semilla de 64 bits
+	void sembrar(uint64_t semilla);
+	
+	// Flujo independiente número "n" de una semilla de sesión
+	static Azar flujo(uint64_t semillaSesion, uint64_t n);
+	
+	// Siguiente número de 32 bits
+	uint32_t siguiente();
+	
+	// Uniforme en [min, max)
+	float uniforme(float min, float max) {
+		// 24 bits altos -> [0, 1) exacto en float
+		return min + (siguiente() >> 8) * (1.0f / 16777216.0f) * (max - min);
+	}
+	
+	// Llena "cantidad" valores uniformes en [min, max)
+	void llenarUniforme(float* destino, int cantidad, float min, float max);
+	
+	// Estado completo, para guardarlo y continuar después
+	void getEstado(uint32_t estado[4]) const;
+	void setEstado(const uint32_t estado[4]);
+	
+private:
+	uint32_t s[4];
+};
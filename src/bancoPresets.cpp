@@ -0,0 +1,267 @@
+/*
+--------------------------------------------------------------
+ bancoPresets.cpp
+
+ Implementación de la clase BancoPresets
+ 
+ La lectura de los .xml se hace con el mismo panel del GUI
+ (gui.loadFromFile + Controles::capturar), así el banco entiende
+ exactamente los mismos archivos que la tecla 'b'. Solo pasa una
+ vez, al arrancar; después el panel entero vuelve a como estaba
+ (ofSerialize / ofDeserialize, lo mismo que usa loadFromFile).
+--------------------------------------------------------------
+*/
+
+#include "bancoPresets.h"
+
+/*
+--------------------------------------------------------------
+ setup(gui, control, carpeta)
+ - Los "lugar_N.tfp" que guardó el banco vuelven a su lugar N
+ - El resto de la carpeta llena los lugares libres en orden alfabético
+ - Los .tfp se leen directo; los .xml pasan por el panel
+ - Deja los controles como estaban y arranca el hilo de escritura
+--------------------------------------------------------------
+*/
+
+void BancoPresets::setup(ofxPanel& gui, Controles& control, const string& carpetaPresets)
+{
+	carpeta = carpetaPresets;
+	
+	ofDirectory dir(carpeta);
+	if(!dir.exists())
+		ofDirectory::createDirectory(carpeta, true, true);
+	
+	dir.allowExt("xml");
+	dir.allowExt("tfp");
+	dir.listDir();
+	dir.sort();
+	
+	// El panel entero (no solo los parámetros: también cromática, morph y
+	// record), para dejarlo como estaba después de leer los .xml
+	ofXml panelAntes;
+	ofSerialize(panelAntes, gui.getParameter());
+	
+	// Primero los guardados por el banco ("lugar_N.tfp" vuelve al lugar N),
+	// después el resto en orden alfabético, en los lugares que quedan libres
+	for(int pasada = 0; pasada < 2; pasada++) {
+		for(size_t i = 0; i < dir.size(); i++) {
+			ofFile archivo = dir.getFile(i);
+			string nombre = archivo.getBaseName();
+			bool esDelBanco = archivo.getExtension() == "tfp" && nombre.compare(0, 6, "lugar_") == 0;
+			if(esDelBanco != (pasada == 0)) continue;
+			
+			int lugar = -1;
+			if(esDelBanco)
+				lugar = (ofToInt(nombre.substr(6)) + NUM_LUGARES - 1) % NUM_LUGARES;
+			else
+				for(int l = 0; l < NUM_LUGARES && lugar < 0; l++)
+					if(!lugares[l].cargado) lugar = l;
+			if(lugar < 0 || lugares[lugar].cargado) continue;
+			
+			Preset& p = lugares[lugar];
+			if(archivo.getExtension() == "tfp") {
+				if(!leerTfp(archivo.getAbsolutePath(), p)) continue;
+			}
+			else {
+				if(!gui.loadFromFile(archivo.getAbsolutePath())) continue;
+				Parametros leido;
+				control.capturar(leido);
+				for(int id = 0; id < NUM_PARAMETROS; id++)
+					p.valores[id] = leido.valores[id];
+			}
+			
+			strncpy(p.nombre, nombre.c_str(), sizeof(p.nombre) - 1);
+			p.nombre[sizeof(p.nombre) - 1] = 0;
+			p.cargado = true;
+			ofLogNotice() << "Preset " << (lugar + 1) % NUM_LUGARES << ": " << p.nombre;
+		}
+	}
+	
+	ofDeserialize(panelAntes, gui.getParameter());
+	
+	startThread();
+}
+
+//--------------------------------------------------------------
+// leerTfp()
+//  Lee un preset binario. Si el archivo tiene menos parámetros
+//  (versión vieja), los que faltan quedan en 0; si tiene más, se ignoran.
+//--------------------------------------------------------------
+
+bool BancoPresets::leerTfp(const string& ruta, Preset& preset)
+{
+	ofBuffer buffer = ofBufferFromFile(ruta, true);
+	if(buffer.size() < sizeof(CabeceraTfp)) return false;
+	
+	CabeceraTfp cabecera;
+	memcpy(&cabecera, buffer.getData(), sizeof(cabecera));
+	if(memcmp(cabecera.magia, "TFP1", 4) != 0) return false;
+	
+	uint32_t disponibles = (buffer.size() - sizeof(cabecera)) / sizeof(float);
+	uint32_t n = min(min(cabecera.numParametros, disponibles), (uint32_t)NUM_PARAMETROS);
+	
+	for(int id = 0; id < NUM_PARAMETROS; id++) preset.valores[id] = 0;
+	memcpy(preset.valores, buffer.getData() + sizeof(cabecera), n * sizeof(float));
+	return true;
+}
+
+// Abre la entrada MIDI donde llegan los Program Change
+void BancoPresets::conectarEntradaMidi(const string& nombre)
+{
+	if(nombre == nombreEntrada) return;
+	
+	if(!nombreEntrada.empty()) {
+		midiIn.removeListener(this);
+		midiIn.closePort();
+		ofLogNotice() << "Se cerró la entrada MIDI " << nombreEntrada;
+		nombreEntrada = "";
+	}
+	
+	if(!nombre.empty() && midiIn.openPort(nombre)) {
+		midiIn.addListener(this);
+		nombreEntrada = nombre;
+		ofLogNotice() << "Presets por Program Change en el puerto MIDI " << nombre;
+	}
+}
+
+// Hilo MIDI: solo guarda el número de programa
+void BancoPresets::newMidiMessage(ofxMidiMessage& mensaje)
+{
+	if(mensaje.status == MIDI_PROGRAM_CHANGE)
+		programaPendiente.store(mensaje.value);
+}
+
+// Pide un preset; se aplica en el próximo update()
+void BancoPresets::recuperar(int lugar, float segundosMorph)
+{
+	if(!estaCargado(lugar)) return;
+	pedidoRecuperar = lugar;
+	pedidoSegundos = segundosMorph;
+}
+
+/*
+--------------------------------------------------------------
+ update(control, ahora, segundosMorph)
+ - Un Program Change 0..9 llama al lugar con ese número
+ - Un pedido nuevo arranca el morph desde los valores actuales
+ - Durante el morph, cada parámetro se interpola linealmente;
+   los toggles cambian al final
+--------------------------------------------------------------
+*/
+
+void BancoPresets::update(Controles& control, double ahora, float segundosMorph)
+{
+	int programa = programaPendiente.exchange(-1);
+	if(programa >= 0 && programa < NUM_LUGARES)
+		recuperar(programa, segundosMorph);
+	
+	if(pedidoRecuperar >= 0) {
+		for(int id = 0; id < NUM_PARAMETROS; id++)
+			morphDesde[id] = control.getParametro(id);
+		morphHacia = pedidoRecuperar;
+		morphInicio = ahora;
+		morphDuracion = pedidoSegundos;
+		morphActivo = true;
+		pedidoRecuperar = -1;
+	}
+	
+	if(!morphActivo) return;
+	
+	float t = morphDuracion > 0 ? ofClamp((float)((ahora - morphInicio) / morphDuracion), 0, 1) : 1;
+	const Preset& destino = lugares[morphHacia];
+	
+	for(int id = 0; id < NUM_PARAMETROS; id++) {
+		bool esToggle = id >= PARAM_RANDOM && id <= PARAM_ACORDES;
+		float valor;
+		if(esToggle)
+			valor = t < 1 ? morphDesde[id] : destino.valores[id];
+		else
+			valor = ofLerp(morphDesde[id], destino.valores[id], t);
+		
+		if(valor != control.getParametro(id))
+			control.setParametro(id, valor);
+	}
+	
+	if(t >= 1) morphActivo = false;
+}
+
+/*
+--------------------------------------------------------------
+ guardar(lugar, control)
+ Copia los parámetros al lugar y encola la escritura del archivo
+ "presets/lugar_N.tfp". El mutex de la cola se toma solo para
+ copiar el preset; el disco lo toca el hilo.
+--------------------------------------------------------------
+*/
+
+void BancoPresets::guardar(int lugar, Controles& control)
+{
+	if(lugar < 0 || lugar >= NUM_LUGARES) return;
+	
+	Preset& p = lugares[lugar];
+	for(int id = 0; id < NUM_PARAMETROS; id++)
+		p.valores[id] = control.getParametro(id);
+	snprintf(p.nombre, sizeof(p.nombre), "lugar_%d", (lugar + 1) % NUM_LUGARES);
+	p.cargado = true;
+	
+	{
+		std::lock_guard<std::mutex> lock(mutexCola);
+		if(colaCantidad == TAM_COLA) {
+			ofLogWarning() << "Cola de escritura de presets llena, no se guarda " << p.nombre;
+			return;
+		}
+		Escritura& e = cola[(colaInicio + colaCantidad) % TAM_COLA];
+		e.lugar = lugar;
+		e.preset = p;
+		colaCantidad++;
+	}
+	hayEscritura.notify_one();
+}
+
+//--------------------------------------------------------------
+// threadedFunction()
+//  Hilo de disco: espera escrituras y las hace de a una.
+//  Al detenerse, termina las que quedaban en la cola.
+//--------------------------------------------------------------
+
+void BancoPresets::threadedFunction()
+{
+	while(true) {
+		Escritura e;
+		{
+			std::unique_lock<std::mutex> lock(mutexCola);
+			hayEscritura.wait(lock, [this]{ return colaCantidad > 0 || !isThreadRunning(); });
+			if(colaCantidad == 0) break;   // detenido y sin nada pendiente
+			e = cola[colaInicio];
+			colaInicio = (colaInicio + 1) % TAM_COLA;
+			colaCantidad--;
+		}
+		
+		CabeceraTfp cabecera;
+		memcpy(cabecera.magia, "TFP1", 4);
+		cabecera.version = 1;
+		cabecera.numParametros = NUM_PARAMETROS;
+		
+		ofBuffer buffer;
+		buffer.set((const char*)&cabecera, sizeof(cabecera));
+		buffer.append((const char*)e.preset.valores, sizeof(e.preset.valores));
+		
+		string ruta = ofFilePath::join(carpeta, string(e.preset.nombre) + ".tfp");
+		if(ofBufferToFile(ruta, buffer, true))
+			ofLogNotice() << "Preset guardado: " << ruta;
+	}
+}
+
+void BancoPresets::exit()
+{
+	{
+		// se terminan de escribir los que estaban en la cola
+		std::unique_lock<std::mutex> lock(mutexCola);
+		stopThread();
+	}
+	hayEscritura.notify_all();
+	waitForThread(false);
+	
+	conectarEntradaMidi("");
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxGui.h"
+#include "ofxMidi.h"
+#include "controlGui.h"
+
+/*
+--------------------------------------------------------------
+ bancoPresets.h
+
+ Clase BancoPresets
+
+ Banco de presets en memoria, para cambiar de escena en vivo
+ sin leer archivos ni parsear XML en medio de la función:
+
+   - Al arrancar lee la carpeta "presets" (dentro de data) una sola
+     vez: los .xml del GUI y los .tfp binarios propios. Cada preset
+     queda en memoria como un arreglo de floats (uno por ParametroId).
+   - Hasta 10 lugares, que se llaman con las teclas 1..9, 0 o con un
+     Program Change MIDI (programa 0..9). Recuperar es O(1).
+   - Un preset puede llegar de golpe o con un "morph": durante unos
+     segundos los parámetros se interpolan tick a tick. Como los CC
+     se mandan solo cuando cambia su valor, el morph solo emite los
+     CC de los parámetros que se mueven.
+   - Guardar copia los parámetros en el lugar (en memoria) y deja la
+     escritura del .tfp a un hilo aparte: el frame nunca espera al disco.
+--------------------------------------------------------------
+*/
+
+class BancoPresets : public ofThread, public ofxMidiListener
+{
+public:
+	static const int NUM_LUGARES = 10;
+	
+	// Precarga la carpeta de presets usando el panel para leer los .xml
+	void setup(ofxPanel& gui, Controles& control, const string& carpeta = "presets");
+	
+	// Escucha Program Change en el puerto MIDI de entrada con ese nombre (opcional).
+	// Se puede volver a llamar cuando cambian los puertos: si el puerto
+	// desapareció lo cierra, y si apareció lo abre. "" = no hay puerto.
+	void conectarEntradaMidi(const string& nombre);
+	
+	// Llama a un preset: de golpe (segundosMorph = 0) o interpolando
+	void recuperar(int lugar, float segundosMorph);
+	
+	// Guarda los parámetros actuales en un lugar y lo escribe en disco en segundo plano
+	void guardar(int lugar, Controles& control);
+	
+	// Avanza el morph y aplica Program Change pendientes (hilo del GUI, una vez por frame).
+	// "ahora" es la hora del Reloj de la simulación, así el morph también sigue al reloj virtual.
+	void update(Controles& control, double ahora, float segundosMorph);
+	
+	// Detiene el hilo de escritura y cierra el MIDI
+	void exit();
+	
+	bool estaCargado(int lugar) { return lugar >= 0 && lugar < NUM_LUGARES && lugares[lugar].cargado; }
+	string getNombre(int lugar) { return estaCargado(lugar) ? string(lugares[lugar].nombre) : ""; }
+	bool enMorph() { return morphActivo; }
+	
+	// Callback de ofxMidi (hilo MIDI)
+	void newMidiMessage(ofxMidiMessage& mensaje);
+	
+private:
+	// Forma compacta de un preset
+	struct Preset {
+		float valores[NUM_PARAMETROS];
+		char nombre[32];
+		bool cargado = false;
+	};
+	
+	// Formato binario .tfp: cabecera + un float por parámetro
+	struct CabeceraTfp {
+		char magia[4];          // "TFP1"
+		uint32_t version;
+		uint32_t numParametros;
+	};
+	
+	bool leerTfp(const string& ruta, Preset& preset);
+	void threadedFunction();
+	
+	Preset lugares[NUM_LUGARES];
+	string carpeta;
+	
+	// Morph
+	bool morphActivo = false;
+	double morphInicio = 0;
+	float morphDuracion = 0;
+	float morphDesde[NUM_PARAMETROS];
+	int morphHacia = -1;
+	int pedidoRecuperar = -1;      // lugar pedido, se aplica en update()
+	float pedidoSegundos = 0;
+	
+	// Program Change que llega del hilo MIDI
+	std::atomic<int> programaPendiente{-1};
+	ofxMidiIn midiIn;
+	string nombreEntrada;          // puerto abierto, "" = ninguno
+	
+	// Cola de escrituras para el hilo de disco
+	static const int TAM_COLA = 16;
+	struct Escritura { int lugar; Preset preset; };
+	Escritura cola[TAM_COLA];
+	int colaInicio = 0, colaCantidad = 0;
+	std::mutex mutexCola;
+	std::condition_variable hayEscritura;
+};
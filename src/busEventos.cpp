@@ -0,0 +1,76 @@
+/*
+--------------------------------------------------------------
+ busEventos.cpp
+
+ Implementación de BusEventos y del suscriptor RegistroEventos.
+--------------------------------------------------------------
+*/
+
+#include "busEventos.h"
+#include "registro.h"
+
+void BusEventos::setup(int capacidad, int reserva)
+{
+	eventos.resize(capacidad);
+	limiteRebotes = max(0, capacidad - reserva);
+	cantidad = 0;
+}
+
+void BusEventos::suscribir(OyenteEventos* oyente)
+{
+	if(numOyentes < MAX_OYENTES)
+		oyentes[numOyentes++] = oyente;
+}
+
+void BusEventos::despachar(uint64_t tick)
+{
+	for(int i = 0; i < numOyentes; i++)
+		oyentes[i]->procesar(eventos.data(), cantidad, tick);
+	cantidad = 0;
+	
+	if(perdidos != perdidosAvisados) {
+		REGISTRO_WARNING("Bus de eventos lleno en el tick {}: {} eventos perdidos ({} en total)",
+						 tick, perdidos - perdidosAvisados, perdidos);
+		perdidosAvisados = perdidos;
+	}
+}
+
+
+//--------------------------------------------------------------
+// RegistroEventos::procesar()
+//--------------------------------------------------------------
+
+void RegistroEventos::procesar(const EventoSimulacion* eventos, int cantidad, uint64_t tick)
+{
+	for(int i = 0; i < cantidad; i++) {
+		const EventoSimulacion& e = eventos[i];
+		switch(e.tipo) {
+			case SIM_PARED:
+			case SIM_OBSTACULO:
+				rebotes++;
+				break;
+
+			case SIM_CONTACTO:
+				choques++;
+				break;
+
+			case SIM_MUERTE:
+				if(muertes == 0)
+					REGISTRO_NOTICE("Murió la primera pelota de la generación {} (tick {})", generacion, tick);
+				muertes++;
+				break;
+
+			case SIM_GENERACION:
+				if(generacion > 0)
+					REGISTRO_NOTICE("Generación {}: {} rebotes, {} choques, {} muertes",
+									generacion, rebotes, choques, muertes);
+				REGISTRO_NOTICE("Generación {}: nacen {} pelotas", e.dato, (int)e.valor);
+				generacion = e.dato;
+				rebotes = choques = muertes = 0;
+				break;
+
+			default:
+				break;
+		}
+	}
+}
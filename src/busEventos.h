@@ -0,0 +1,125 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ busEventos.h
+
+ Clase BusEventos
+
+ La física no manda MIDI, ni registra, ni dibuja: anota lo que
+ pasó en el tick como eventos tipados, y al final del tick el bus
+ se los pasa, todos juntos y en orden, a cada suscriptor:
+
+   - MidiSender:      notas y CC
+   - RegistroEventos: mensajes de diagnóstico por generación
+   - Destellos:       marcas visuales de los rebotes y choques
+
+ Los eventos del tick se escriben en un arreglo reservado en
+ setup(): publicar() no pide memoria ni bloquea. Si se llena, el
+ evento se descarta, se cuenta (getPerdidos) y despachar() lo
+ registra. Los rebotes (pared, obstáculo, choque) no pueden usar
+ las últimas "reserva" casillas: esas quedan para las notas y los
+ nacimientos y muertes, así un Note Off no se pierde porque el tick
+ tuvo muchos choques.
+ Un suscriptor recibe el lote completo del tick, así puede
+ agruparlo o pasarlo a otro hilo sin tocar la física.
+
+ Hilos: se publica y se despacha desde el hilo de la simulación
+ (o desde el del GUI con la simulación sincronizada).
+--------------------------------------------------------------
+*/
+
+enum TipoEventoSimulacion : uint8_t {
+	SIM_NOTA_ON,       // la pelota empieza a sonar (nota, salida)
+	SIM_NOTA_OFF,      // la pelota suelta la nota (nota, salida)
+	SIM_PARED,         // rebote contra una pared (pared)
+	SIM_OBSTACULO,     // rebote contra un obstáculo (nota y cc del obstáculo)
+	SIM_CONTACTO,      // choque entre dos pelotas (valor = impulso)
+	SIM_NACIMIENTO,    // nace una pelota (nota, valor = radio)
+	SIM_MUERTE,        // muere una pelota (nota)
+	SIM_GENERACION     // empieza una generación (dato = número, valor = pelotas)
+};
+
+enum ParedMarco : uint8_t {
+	PARED_IZQUIERDA,
+	PARED_DERECHA,
+	PARED_ARRIBA,
+	PARED_ABAJO
+};
+
+struct EventoSimulacion {
+	TipoEventoSimulacion tipo;
+	uint8_t pared = 0;
+	uint8_t salida = 0;      // salida MIDI de la pelota
+	int16_t nota = -1;
+	int16_t cc = -1;
+	float x = 0, y = 0;      // dónde pasó
+	float valor = 0;
+	uint32_t dato = 0;
+};
+
+// Quien quiere enterarse de los eventos de cada tick
+class OyenteEventos {
+public:
+	virtual ~OyenteEventos() {}
+	virtual void procesar(const EventoSimulacion* eventos, int cantidad, uint64_t tick) = 0;
+};
+
+class BusEventos
+{
+public:
+	static const int MAX_OYENTES = 8;
+
+	// Reserva lugar para "capacidad" eventos por tick, de los cuales
+	// "reserva" son solo para eventos que no son rebotes
+	void setup(int capacidad, int reserva);
+
+	// Agrega un suscriptor (en el orden en que reciben)
+	void suscribir(OyenteEventos* oyente);
+
+	// Anota un evento del tick en curso
+	void publicar(const EventoSimulacion& e) {
+		int limite = esRebote(e.tipo) ? limiteRebotes : (int)eventos.size();
+		if(cantidad < limite) eventos[cantidad++] = e;
+		else perdidos++;
+	}
+
+	// Entrega los eventos anotados a todos los suscriptores y vacía el tick
+	void despachar(uint64_t tick);
+
+	int size() { return cantidad; }
+	uint64_t getPerdidos() { return perdidos; }
+
+private:
+	static bool esRebote(TipoEventoSimulacion tipo) {
+		return tipo == SIM_PARED || tipo == SIM_OBSTACULO || tipo == SIM_CONTACTO;
+	}
+	
+	vector<EventoSimulacion> eventos;
+	int cantidad = 0;
+	int limiteRebotes = 0;
+	OyenteEventos* oyentes[MAX_OYENTES];
+	int numOyentes = 0;
+	uint64_t perdidos = 0;
+	uint64_t perdidosAvisados = 0;
+};
+
+
+/*
+--------------------------------------------------------------
+ RegistroEventos
+ Suscriptor de diagnóstico: cuenta lo que pasa en cada generación
+ y lo registra (REGISTRO_*) cuando empieza la siguiente y cuando
+ muere la primera pelota.
+--------------------------------------------------------------
+*/
+
+class RegistroEventos : public OyenteEventos {
+public:
+	void procesar(const EventoSimulacion* eventos, int cantidad, uint64_t tick) override;
+
+private:
+	uint32_t generacion = 0;
+	uint64_t rebotes = 0, choques = 0, muertes = 0;
+};
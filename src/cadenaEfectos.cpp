@@ -0,0 +1,307 @@
+/*
+--------------------------------------------------------------
+ cadenaEfectos.cpp
+
+ Implementación de la clase CadenaEfectos
+--------------------------------------------------------------
+*/
+
+#include "cadenaEfectos.h"
+#include "azar.h"
+#include <chrono>
+
+void CadenaEfectos::setup(int frecuenciaMuestreo)
+{
+	frecuencia = frecuenciaMuestreo;
+	float escala = frecuencia / 44100.0f;
+	
+	// hasta 2.5 s de eco (el máximo del slider "tiempo")
+	delay.buffer.assign((int)(2.5f * frecuencia) + 1, 0.0f);
+	
+	// demoras clásicas de Freeverb, en samples a 44100 Hz
+	const int baseCombs[4] = {1116, 1188, 1277, 1356};
+	const int baseAllpass[2] = {556, 441};
+	for(int k = 0; k < 4; k++) {
+		demoraCombs[k] = (int)(baseCombs[k] * escala);
+		combs[k].buffer.assign(demoraCombs[k], 0.0f);
+	}
+	for(int k = 0; k < 2; k++) {
+		demoraAllpass[k] = (int)(baseAllpass[k] * escala);
+		allpasses[k].buffer.assign(demoraAllpass[k], 0.0f);
+	}
+	
+	mono.assign(MAX_BLOQUE, 0.0f);
+	eco.assign(MAX_BLOQUE, 0.0f);
+	humedo.assign(MAX_BLOQUE, 0.0f);
+	
+	// sin efecto hasta que lleguen los sliders
+	const float inicial[NUM_CONTROLES] = {0, 100, 0, 250, 0, 0};
+	for(int c = 0; c < NUM_CONTROLES; c++) {
+		objetivo[c] = inicial[c];
+		actual[c] = inicial[c];
+	}
+}
+
+void CadenaEfectos::setParametros(const Parametros& par)
+{
+	objetivo[DISTORSION]    = par.get(PARAM_DISTORSION);
+	objetivo[FILTRO]        = par.get(PARAM_FILTRO);
+	objetivo[MEZCLA_DELAY]  = par.get(PARAM_DELAY) / 100.0f;
+	objetivo[TIEMPO]        = par.get(PARAM_TIEMPO);
+	objetivo[FEEDBACK]      = min(par.get(PARAM_FEEDBACK) / 100.0f, 0.95f);   // más de 0.95 no se apaga nunca
+	objetivo[MEZCLA_REVERB] = par.get(PARAM_REVERB) / 100.0f * 0.6f;
+}
+
+void CadenaEfectos::procesar(float* buffer, int cantidad, int canales)
+{
+	for(int inicio = 0; inicio < cantidad; inicio += MAX_BLOQUE) {
+		int n = min(cantidad - inicio, MAX_BLOQUE);
+		float* bloque = buffer + inicio * canales;
+		
+		for(int i = 0; i < n; i++)
+			mono[i] = bloque[i * canales];
+		
+		procesarMono(mono.data(), n);
+		
+		for(int i = 0; i < n; i++)
+			for(int c = 0; c < canales; c++)
+				bloque[i * canales + c] = mono[i];
+	}
+}
+
+/*
+--------------------------------------------------------------
+ procesarMono(x, n)
+ Suaviza los controles (un paso de un polo por bloque) y aplica
+ la cadena. Los valores que cambian dentro del bloque van en rampa
+ desde el valor del bloque anterior.
+--------------------------------------------------------------
+*/
+
+void CadenaEfectos::procesarMono(float* x, int n)
+{
+	float anterior[NUM_CONTROLES];
+	for(int c = 0; c < NUM_CONTROLES; c++) {
+		anterior[c] = actual[c];
+		float o = objetivo[c].load(std::memory_order_relaxed);
+		actual[c] += (o - actual[c]) * 0.3f;
+		if(o == 0 && actual[c] < 1e-4f) actual[c] = 0;   // que la mezcla llegue a 0 de verdad
+	}
+	float rampa = 1.0f / n;
+	
+	// Distorsión: saturación suave, mezclada con la señal limpia por debajo de 1
+	if(anterior[DISTORSION] > 0 || actual[DISTORSION] > 0) {
+		float k0 = 1 + 2 * anterior[DISTORSION], k1 = 1 + 2 * actual[DISTORSION];
+		float a0 = min(anterior[DISTORSION], 1.0f), a1 = min(actual[DISTORSION], 1.0f);
+		for(int i = 0; i < n; i++) {
+			float t = i * rampa;
+			float k = k0 + (k1 - k0) * t;
+			float a = a0 + (a1 - a0) * t;
+			float s = x[i] * k / (1 + std::abs(x[i] * k));
+			x[i] += a * (s - x[i]);
+		}
+	}
+	
+	// Filtro pasa bajos de un polo (recursivo)
+	if(actual[FILTRO] < 100) {
+		float corte = 200.0f * powf(100.0f, actual[FILTRO] / 100.0f);
+		float coef = 1.0f - expf(-TWO_PI * corte / frecuencia);
+		float z = estadoFiltro;
+		for(int i = 0; i < n; i++) {
+			z += coef * (x[i] - z);
+			x[i] = z;
+		}
+		estadoFiltro = z;
+	}
+	else
+		estadoFiltro = x[n - 1];
+	
+	// Delay con feedback. La demora va en samples enteros de un bloque a otro;
+	// si cambió, adentro del bloque va en rampa con lectura fraccionaria.
+	if(anterior[MEZCLA_DELAY] > 0 || actual[MEZCLA_DELAY] > 0) {
+		float maximo = delay.buffer.size() - 2;
+		int demora0 = (int)round(ofClamp(anterior[TIEMPO] * frecuencia / 1000.0f, 1, maximo));
+		int demora1 = (int)round(ofClamp(actual[TIEMPO] * frecuencia / 1000.0f, 1, maximo));
+		std::fill(eco.begin(), eco.begin() + n, 0.0f);
+		if(demora0 == demora1)
+			comb(delay, demora1, actual[FEEDBACK], x, eco.data(), n);
+		else
+			combVariable(delay, demora0, demora1, actual[FEEDBACK], x, eco.data(), n);
+		delayEnUso = true;
+		
+		float m0 = anterior[MEZCLA_DELAY], m1 = actual[MEZCLA_DELAY];
+		for(int i = 0; i < n; i++)
+			x[i] += (m0 + (m1 - m0) * i * rampa) * eco[i];
+	}
+	else if(delayEnUso) {
+		vaciar(delay);
+		delayEnUso = false;
+	}
+	
+	// Reverb: combs en paralelo y dos allpass en serie
+	if(anterior[MEZCLA_REVERB] > 0 || actual[MEZCLA_REVERB] > 0) {
+		reverbEnUso = true;
+		std::fill(humedo.begin(), humedo.begin() + n, 0.0f);
+		for(int k = 0; k < 4; k++)
+			comb(combs[k], demoraCombs[k], 0.84f, x, humedo.data(), n);
+		for(int i = 0; i < n; i++)
+			humedo[i] *= 0.25f;
+		for(int k = 0; k < 2; k++)
+			allpass(allpasses[k], demoraAllpass[k], 0.5f, humedo.data(), n);
+		
+		float m0 = anterior[MEZCLA_REVERB], m1 = actual[MEZCLA_REVERB];
+		for(int i = 0; i < n; i++)
+			x[i] += (m0 + (m1 - m0) * i * rampa) * humedo[i];
+	}
+	else if(reverbEnUso) {
+		for(int k = 0; k < 4; k++) vaciar(combs[k]);
+		for(int k = 0; k < 2; k++) vaciar(allpasses[k]);
+		reverbEnUso = false;
+	}
+}
+
+// Sin mezcla la línea deja de escribirse: se vacía una vez, para no guardar audio viejo
+void CadenaEfectos::vaciar(Linea& linea)
+{
+	std::fill(linea.buffer.begin(), linea.buffer.end(), 0.0f);
+	linea.pos = 0;
+}
+
+/*
+--------------------------------------------------------------
+ comb(linea, demora, ganancia, entrada, salida, n)
+ salida += línea demorada; línea = entrada + ganancia * demorada.
+ Se recorre en tramos sin vuelta del buffer y de largo menor o
+ igual a la demora: adentro de un tramo las lecturas son todas de
+ muestras escritas antes del tramo.
+--------------------------------------------------------------
+*/
+
+void CadenaEfectos::comb(Linea& linea, int demora, float ganancia, const float* entrada, float* salida, int n)
+{
+	float* buffer = linea.buffer.data();
+	int largo = linea.buffer.size();
+	int hecho = 0;
+	
+	while(hecho < n) {
+		int escritura = linea.pos;
+		int lectura = escritura - demora;
+		if(lectura < 0) lectura += largo;
+		int tramo = min(min(n - hecho, demora), min(largo - escritura, largo - lectura));
+		
+		for(int i = 0; i < tramo; i++) {
+			float y = buffer[lectura + i];
+			salida[hecho + i] += y;
+			buffer[escritura + i] = entrada[hecho + i] + ganancia * y;
+		}
+		
+		hecho += tramo;
+		linea.pos = (escritura + tramo) % largo;
+	}
+}
+
+/*
+--------------------------------------------------------------
+ combVariable(linea, demora0, demora1, ganancia, entrada, salida, n)
+ Lo mismo que comb, con la demora en rampa de demora0 a demora1 a
+ lo largo del bloque y la lectura interpolada entre dos muestras.
+ Con demora >= 1 se lee siempre algo ya escrito. Queda escalar:
+ solo corre en los bloques en que se mueve el tiempo del delay.
+--------------------------------------------------------------
+*/
+
+void CadenaEfectos::combVariable(Linea& linea, float demora0, float demora1, float ganancia,
+								 const float* entrada, float* salida, int n)
+{
+	float* buffer = linea.buffer.data();
+	int largo = linea.buffer.size();
+	float paso = (demora1 - demora0) / n;
+	int escritura = linea.pos;
+	
+	for(int i = 0; i < n; i++) {
+		float lectura = escritura - (demora0 + paso * i);
+		if(lectura < 0) lectura += largo;
+		int a = (int)lectura;
+		int b = a + 1 < largo ? a + 1 : 0;
+		float f = lectura - a;
+		float y = buffer[a] + f * (buffer[b] - buffer[a]);
+		salida[i] += y;
+		buffer[escritura] = entrada[i] + ganancia * y;
+		if(++escritura == largo) escritura = 0;
+	}
+	linea.pos = escritura;
+}
+
+// allpass en el lugar: y = demorada - g*x; línea = x + g*y
+void CadenaEfectos::allpass(Linea& linea, int demora, float ganancia, float* x, int n)
+{
+	float* buffer = linea.buffer.data();
+	int largo = linea.buffer.size();
+	int hecho = 0;
+	
+	while(hecho < n) {
+		int escritura = linea.pos;
+		int lectura = escritura - demora;
+		if(lectura < 0) lectura += largo;
+		int tramo = min(min(n - hecho, demora), min(largo - escritura, largo - lectura));
+		
+		for(int i = 0; i < tramo; i++) {
+			float entrada = x[hecho + i];
+			float y = buffer[lectura + i] - ganancia * entrada;
+			buffer[escritura + i] = entrada + ganancia * y;
+			x[hecho + i] = y;
+		}
+		
+		hecho += tramo;
+		linea.pos = (escritura + tramo) % largo;
+	}
+}
+
+/*
+--------------------------------------------------------------
+ benchmark()
+ Pasa 10 segundos de ruido por la cadena con todos los efectos
+ a mitad de camino, en bloques de 64, 128 y 256 frames estéreo,
+ y muestra el tiempo por bloque y qué parte del tiempo real usa.
+--------------------------------------------------------------
+*/
+
+void CadenaEfectos::benchmark()
+{
+	const int frecuenciaPrueba = 44100;
+	const int tamanos[3] = {64, 128, 256};
+	
+	Parametros par;
+	par.valores[PARAM_DISTORSION] = 5;
+	par.valores[PARAM_FILTRO]     = 60;
+	par.valores[PARAM_DELAY]      = 40;
+	par.valores[PARAM_TIEMPO]     = 300;
+	par.valores[PARAM_FEEDBACK]   = 50;
+	par.valores[PARAM_REVERB]     = 50;
+	
+	for(int tamano : tamanos) {
+		auto cadena = std::make_unique<CadenaEfectos>();
+		cadena->setup(frecuenciaPrueba);
+		cadena->setParametros(par);
+		
+		Azar azar(tamano);
+		vector<float> bloque(tamano * 2);
+		int bloques = frecuenciaPrueba * 10 / tamano;
+		
+		double total = 0;
+		for(int b = 0; b < bloques; b++) {
+			for(float& muestra : bloque)
+				muestra = azar.uniforme(-0.5f, 0.5f);
+			
+			auto inicio = std::chrono::steady_clock::now();
+			cadena->procesar(bloque.data(), tamano, 2);
+			total += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count();
+		}
+		
+		double microsBloque = total / bloques;
+		double microsTiempoReal = tamano * 1e6 / frecuenciaPrueba;
+		ofLogNotice("CadenaEfectos") << "bloque de " << tamano << " frames: "
+									 << ofToString(microsBloque, 2) << " us ("
+									 << ofToString(100.0 * microsBloque / microsTiempoReal, 3) << " % del tiempo real)";
+	}
+}
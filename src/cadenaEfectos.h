@@ -0,0 +1,86 @@
+#pragma once
+#include "ofMain.h"
+#include "parametros.h"
+
+/*
+--------------------------------------------------------------
+ cadenaEfectos.h
+
+ Clase CadenaEfectos
+
+ Los efectos del grupo "Efectos" del GUI, calculados dentro de la
+ aplicación sobre la salida del sintetizador interno, en lugar de
+ mandarlos como CC 29..36 a un DAW:
+
+   distorsión -> filtro pasa bajos -> delay con feedback -> reverb
+
+   - distorsion  saturación suave x*k / (1 + |x*k|), k = 1 + 2*distorsion
+   - filtro      pasa bajos de un polo, de 200 Hz (0) a 20 kHz (100)
+   - delay       mezcla del eco (0..100 %), "tiempo" en ms, "feedback" en %
+   - reverb      mezcla de una reverb de Schroeder (4 combs + 2 allpass)
+
+ Los parámetros llegan desde el tick de simulación (setParametros) y se
+ suavizan bloque a bloque en el callback, con rampas lineales adentro de
+ cada bloque, así que mover un slider no hace clicks. El tiempo del delay
+ también va en rampa: mientras cambia, la lectura es fraccionaria
+ (interpolación lineal) y el eco se estira en vez de saltar.
+ Cuando la mezcla del delay o de la reverb llega a 0, sus líneas se
+ vacían: al volver a subirla no suena audio viejo.
+
+ Todo se reserva en setup(): procesar() no reserva memoria. Los lazos
+ sobre el bloque no tienen saltos, y los de delay y reverb se cortan en
+ tramos sin vuelta del buffer circular y no más largos que la demora,
+ para que ninguna muestra dependa de otra del mismo tramo: así los
+ vectoriza el compilador. El filtro de un polo es recursivo y queda escalar.
+--------------------------------------------------------------
+*/
+
+class CadenaEfectos
+{
+public:
+	static const int MAX_BLOQUE = 4096;
+	
+	void setup(int frecuenciaMuestreo);
+	
+	// Nuevos valores de los sliders de efectos (productor: tick de simulación)
+	void setParametros(const Parametros& par);
+	
+	// Procesa un bloque intercalado en el lugar (callback de audio).
+	// Usa el primer canal y copia el resultado a todos.
+	void procesar(float* buffer, int cantidad, int canales);
+	
+	// CPU por bloque a 64, 128 y 256 frames, impreso en la consola
+	static void benchmark();
+	
+private:
+	enum Control { DISTORSION, FILTRO, MEZCLA_DELAY, TIEMPO, FEEDBACK, MEZCLA_REVERB, NUM_CONTROLES };
+	
+	// Buffer circular con su posición de escritura
+	struct Linea {
+		vector<float> buffer;
+		int pos = 0;
+	};
+	
+	void procesarMono(float* x, int n);
+	void comb(Linea& linea, int demora, float ganancia, const float* entrada, float* salida, int n);
+	void combVariable(Linea& linea, float demora0, float demora1, float ganancia, const float* entrada, float* salida, int n);
+	void vaciar(Linea& linea);
+	void allpass(Linea& linea, int demora, float ganancia, float* x, int n);
+	
+	float frecuencia = 44100;
+	
+	std::atomic<float> objetivo[NUM_CONTROLES];   // escritos por el productor
+	float actual[NUM_CONTROLES];                  // suavizados (audio)
+	
+	float estadoFiltro = 0;
+	Linea delay;
+	Linea combs[4];
+	Linea allpasses[2];
+	int demoraCombs[4];
+	int demoraAllpass[2];
+	bool delayEnUso = false;     // las líneas tienen algo desde la última vez que se vaciaron
+	bool reverbEnUso = false;
+	
+	// Espacio de trabajo de un bloque
+	vector<float> mono, eco, humedo;
+};
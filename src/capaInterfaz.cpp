@@ -0,0 +1,83 @@
+/*
+--------------------------------------------------------------
+ capaInterfaz.cpp
+
+ Implementación de la clase CapaInterfaz
+--------------------------------------------------------------
+*/
+
+#include "capaInterfaz.h"
+
+CapaInterfaz::~CapaInterfaz()
+{
+	if(panel != nullptr)
+		ofRemoveListener(panel->getParameter().castGroup().parameterChangedE(), this, &CapaInterfaz::parametroCambiado);
+}
+
+void CapaInterfaz::setup(ofxPanel& gui, int ancho, int alto)
+{
+	panel = &gui;
+	// El grupo del panel avisa también los cambios de sus subgrupos
+	ofAddListener(gui.getParameter().castGroup().parameterChangedE(), this, &CapaInterfaz::parametroCambiado);
+	redimensionar(ancho, alto);
+}
+
+void CapaInterfaz::redimensionar(int nuevoAncho, int nuevoAlto)
+{
+	ancho = nuevoAncho;
+	alto = nuevoAlto;
+	sucia = true;
+}
+
+void CapaInterfaz::parametroCambiado(ofAbstractParameter& parametro)
+{
+	sucia = true;
+}
+
+/*
+--------------------------------------------------------------
+ hayQueRedibujar(firma)
+ Compara la firma con la del último redibujo. Si no cambió nada,
+ la capa guardada sigue valiendo y el frame solo la compone.
+ Con un intervalo mayor que 1, lo sucio espera hasta que pasen
+ esos frames desde el último redibujo (no se pierde, se demora).
+--------------------------------------------------------------
+*/
+
+bool CapaInterfaz::hayQueRedibujar(uint64_t firma)
+{
+	if(firma != ultimaFirma) {
+		ultimaFirma = firma;
+		sucia = true;
+	}
+	if(framesDesdeRedibujo + 1 < intervalo) {
+		framesDesdeRedibujo++;
+		return false;
+	}
+	if(!sucia.exchange(false)) return false;
+	framesDesdeRedibujo = 0;
+	return true;
+}
+
+void CapaInterfaz::begin()
+{
+	if(!fbo.isAllocated() || fbo.getWidth() != ancho || fbo.getHeight() != alto)
+		fbo.allocate(ancho, alto, GL_RGBA);
+	fbo.begin();
+	ofClear(0, 0, 0, 0);
+}
+
+void CapaInterfaz::end()
+{
+	fbo.end();
+	redibujos++;
+}
+
+void CapaInterfaz::draw()
+{
+	if(!fbo.isAllocated()) return;
+	ofSetColor(255);
+	ofEnableAlphaBlending();
+	fbo.draw(0, 0, ofGetWidth(), ofGetHeight());
+	ofDisableAlphaBlending();
+}
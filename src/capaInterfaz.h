@@ -0,0 +1,64 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxGui.h"
+
+/*
+--------------------------------------------------------------
+ capaInterfaz.h
+
+ Clase CapaInterfaz
+
+ Guarda el panel del GUI y el texto de información en un FBO propio
+ y lo compone sobre la pantalla con un solo cuadro texturizado.
+ El panel y el mensaje cambian muy de vez en cuando: redibujarlos
+ control por control en cada frame cuesta más cuanto más grande es
+ el panel, y casi siempre da la misma imagen.
+
+ La capa se vuelve a dibujar solamente cuando queda "sucia":
+   - cambió cualquier parámetro del panel (evento del grupo),
+   - cambió la firma del frame (visibilidad de GUI/info, contadores),
+   - hubo un click sobre el panel (abrir/cerrar grupos no es parámetro),
+   - cambió el tamaño de la ventana.
+--------------------------------------------------------------
+*/
+
+class CapaInterfaz
+{
+public:
+	~CapaInterfaz();
+	
+	// Escucha los cambios de todos los parámetros del panel
+	void setup(ofxPanel& gui, int ancho, int alto);
+	void redimensionar(int ancho, int alto);
+	
+	// Fuerza el redibujo en el próximo frame
+	void marcarSucia() { sucia = true; }
+	
+	// Frames mínimos entre redibujos (1 = cuando haga falta). Lo baja ControlCalidad.
+	void setIntervalo(int frames) { intervalo = max(1, frames); }
+	
+	// true si hay que volver a dibujar la capa. La firma resume el
+	// resto del estado que se ve en la capa (visibilidad, contadores).
+	bool hayQueRedibujar(uint64_t firma);
+	
+	// Dibujar el contenido entre begin() y end()
+	void begin();
+	void end();
+	
+	// Compone la capa guardada sobre la pantalla
+	void draw();
+	
+	int getRedibujos() { return redibujos; }
+	
+private:
+	void parametroCambiado(ofAbstractParameter& parametro);
+	
+	ofFbo fbo;                      // se reserva en el primer begin()
+	int ancho = 0, alto = 0;
+	ofxPanel* panel = nullptr;
+	std::atomic<bool> sucia{true};
+	uint64_t ultimaFirma = 0;
+	int redibujos = 0;
+	int intervalo = 1;
+	int framesDesdeRedibujo = 0;
+};
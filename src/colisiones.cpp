@@ -0,0 +1,53 @@
+/*
+--------------------------------------------------------------
+ colisiones.cpp
+
+ Implementación de las pruebas de contacto barridas.
+
+ Para dos círculos se trabaja con el movimiento relativo: el
+ primero queda quieto y el segundo se mueve mov2 - mov1. El
+ contacto es la primera raíz de |p + d*t| = sumaRadios, una
+ ecuación de segundo grado en t.
+--------------------------------------------------------------
+*/
+
+#include "colisiones.h"
+
+float tiempoImpactoCirculos(ofVec2f pos1, ofVec2f mov1, ofVec2f pos2, ofVec2f mov2, float sumaRadios)
+{
+	ofVec2f p = pos2 - pos1;           // posición relativa inicial
+	ofVec2f d = mov2 - mov1;           // desplazamiento relativo
+	
+	float a = d.x * d.x + d.y * d.y;
+	float b = 2 * (p.x * d.x + p.y * d.y);
+	float c = p.x * p.x + p.y * p.y - sumaRadios * sumaRadios;
+	
+	if(c < 0) return -1;               // ya se solapaban: lo resuelve la prueba discreta
+	if(a == 0 || b >= 0) return -1;    // no se mueven entre sí, o se alejan
+	
+	float discriminante = b * b - 4 * a * c;
+	if(discriminante < 0) return -1;   // pasan sin tocarse
+	
+	float t = (-b - sqrt(discriminante)) / (2 * a);
+	if(t < 0 || t > 1) return -1;      // el contacto cae fuera de este recorrido
+	return t;
+}
+
+float tiempoImpactoPared(float pos, float mov, float radio, float min, float max, int& lado)
+{
+	lado = 0;
+	
+	if(mov < 0) {
+		float limite = min + radio;
+		if(pos + mov >= limite || pos < limite) return -1;
+		lado = -1;
+		return (limite - pos) / mov;
+	}
+	if(mov > 0) {
+		float limite = max - radio;
+		if(pos + mov <= limite || pos > limite) return -1;
+		lado = 1;
+		return (limite - pos) / mov;
+	}
+	return -1;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ colisiones.h
+
+ Pruebas de contacto "barridas" (swept) para círculos.
+
+ En lugar de preguntar si dos pelotas se solapan al final del
+ frame, se mira todo el recorrido del frame y se calcula en qué
+ fracción del recorrido (t entre 0 y 1) se tocan por primera vez.
+ Así una pelota rápida no puede atravesar a otra ni a una pared
+ entre un frame y el siguiente.
+--------------------------------------------------------------
+*/
+
+// Fracción t del recorrido en que dos círculos empiezan a tocarse.
+//   pos1, pos2 - centros al comienzo del recorrido
+//   mov1, mov2 - desplazamiento de cada centro en todo el recorrido
+//   sumaRadios - distancia de contacto
+// Devuelve -1 si no se tocan, o si ya estaban solapados al comenzar.
+float tiempoImpactoCirculos(ofVec2f pos1, ofVec2f mov1, ofVec2f pos2, ofVec2f mov2, float sumaRadios);
+
+// Fracción t del recorrido en que un círculo toca una pared en un eje.
+//   pos, mov  - coordenada del centro y desplazamiento en ese eje
+//   radio     - radio del círculo
+//   min, max  - posición de las dos paredes en ese eje
+// Devuelve -1 si no hay contacto; en "lado" deja -1 (pared min) o +1 (pared max).
+float tiempoImpactoPared(float pos, float mov, float radio, float min, float max, int& lado);
@@ -0,0 +1,100 @@
+/*
+--------------------------------------------------------------
+ contadorMemoria.cpp
+
+ Contadores por etapa y, con TF_CONTAR_MEMORIA, el reemplazo
+ del operator new/delete global.
+--------------------------------------------------------------
+*/
+
+#include "contadorMemoria.h"
+#include <cstdlib>
+#include <new>
+
+thread_local EtapaMemoria ContadorMemoria::etapaHilo = ETAPA_FUERA_DEL_FRAME;
+std::atomic<uint64_t> ContadorMemoria::asignaciones[NUM_ETAPAS];
+std::atomic<uint64_t> ContadorMemoria::bytes[NUM_ETAPAS];
+ConteoMemoria ContadorMemoria::anterior;
+ConteoMemoria ContadorMemoria::frame;
+
+bool ContadorMemoria::activo()
+{
+#ifdef TF_CONTAR_MEMORIA
+	return true;
+#else
+	return false;
+#endif
+}
+
+void ContadorMemoria::contar(size_t n)
+{
+	asignaciones[etapaHilo].fetch_add(1, std::memory_order_relaxed);
+	bytes[etapaHilo].fetch_add(n, std::memory_order_relaxed);
+}
+
+ConteoMemoria ContadorMemoria::total()
+{
+	ConteoMemoria c;
+	for(int e = 0; e < NUM_ETAPAS; e++) {
+		c.asignaciones[e] = asignaciones[e].load(std::memory_order_relaxed);
+		c.bytes[e] = bytes[e].load(std::memory_order_relaxed);
+	}
+	return c;
+}
+
+void ContadorMemoria::cerrarFrame()
+{
+	ConteoMemoria ahora = total();
+	for(int e = 0; e < NUM_ETAPAS; e++) {
+		frame.asignaciones[e] = ahora.asignaciones[e] - anterior.asignaciones[e];
+		frame.bytes[e] = ahora.bytes[e] - anterior.bytes[e];
+	}
+	anterior = ahora;
+}
+
+const char* ContadorMemoria::nombre(int etapa)
+{
+	static const char* nombres[NUM_ETAPAS] = {
+		"fuera del frame", "update", "simulacion", "draw", "interfaz", "audio"
+	};
+	return (etapa >= 0 && etapa < NUM_ETAPAS) ? nombres[etapa] : "?";
+}
+
+
+/*
+--------------------------------------------------------------
+ operator new / delete
+ Cuentan y delegan en malloc/free. Las variantes con alineación
+ (C++17) no se reemplazan: las de la biblioteca quedan en pareja.
+--------------------------------------------------------------
+*/
+
+#ifdef TF_CONTAR_MEMORIA
+
+static void* pedir(size_t n)
+{
+	ContadorMemoria::contar(n);
+	void* p = std::malloc(n ? n : 1);
+	if(p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+static void* pedirSinExcepcion(size_t n) noexcept
+{
+	ContadorMemoria::contar(n);
+	return std::malloc(n ? n : 1);
+}
+
+void* operator new(size_t n)                                 { return pedir(n); }
+void* operator new[](size_t n)                               { return pedir(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept   { return pedirSinExcepcion(n); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return pedirSinExcepcion(n); }
+
+void operator delete(void* p) noexcept                              { std::free(p); }
+void operator delete[](void* p) noexcept                            { std::free(p); }
+void operator delete(void* p, size_t) noexcept                      { std::free(p); }
+void operator delete[](void* p, size_t) noexcept                    { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept       { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept     { std::free(p); }
+
+#endif
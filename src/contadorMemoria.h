@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/*
+--------------------------------------------------------------
+ contadorMemoria.h
+
+ Cuenta los pedidos de memoria (operator new) por etapa del frame,
+ para saber si una función en marcha toca el heap y dónde.
+
+ Se activa al compilar con TF_CONTAR_MEMORIA (en PROJECT_DEFINES,
+ como TF_NIVEL_REGISTRO). Sin esa definición no se reemplaza
+ operator new y MEDIR_MEMORIA desaparece del código.
+
+   - contadorMemoria.cpp reemplaza el operator new/delete global:
+     cada pedido suma uno y sus bytes a la etapa del hilo que lo hizo.
+   - MEDIR_MEMORIA(ETAPA_DRAW) marca la etapa del hilo hasta el final
+     del bloque (y después vuelve a la anterior).
+   - cerrarFrame(), una vez por frame, deja en ultimoFrame() lo que
+     pidió cada etapa desde el frame anterior.
+   - Lo que piden hilos sin etapa (registro, escritores MIDI, OSC)
+     va a ETAPA_FUERA_DEL_FRAME, igual que lo que pasa en los eventos
+     de teclado y mouse: no es parte del frame.
+
+ ofApp lo muestra en la info en pantalla ('i') y --test-alloc lo
+ usa para fallar si una escena estable pide memoria.
+--------------------------------------------------------------
+*/
+
+enum EtapaMemoria {
+	ETAPA_FUERA_DEL_FRAME = 0,   // otros hilos, y eventos de teclado y mouse
+	ETAPA_UPDATE,
+	ETAPA_SIMULACION,
+	ETAPA_DRAW,
+	ETAPA_INTERFAZ,
+	ETAPA_AUDIO,
+	NUM_ETAPAS
+};
+
+struct ConteoMemoria {
+	uint64_t asignaciones[NUM_ETAPAS] = {0};
+	uint64_t bytes[NUM_ETAPAS] = {0};
+
+	// Suma de las etapas del frame (sin otros hilos)
+	uint64_t asignacionesFrame() const {
+		uint64_t total = 0;
+		for(int e = ETAPA_UPDATE; e < NUM_ETAPAS; e++) total += asignaciones[e];
+		return total;
+	}
+};
+
+class ContadorMemoria
+{
+public:
+	// true si se compiló con TF_CONTAR_MEMORIA
+	static bool activo();
+
+	// Lo que se pidió desde la última llamada queda en ultimoFrame()
+	static void cerrarFrame();
+	static const ConteoMemoria& ultimoFrame() { return frame; }
+
+	// Desde que arrancó la aplicación
+	static ConteoMemoria total();
+
+	static const char* nombre(int etapa);
+
+	// Etapa del hilo que llama (la usa operator new)
+	static EtapaMemoria etapaActual() { return etapaHilo; }
+	static void contar(size_t bytes);
+
+private:
+	friend class EtapaMedida;
+
+	static thread_local EtapaMemoria etapaHilo;
+	static std::atomic<uint64_t> asignaciones[NUM_ETAPAS];
+	static std::atomic<uint64_t> bytes[NUM_ETAPAS];
+	static ConteoMemoria anterior;     // total al cerrar el frame anterior
+	static ConteoMemoria frame;
+};
+
+// Marca la etapa del hilo mientras vive el objeto
+class EtapaMedida
+{
+public:
+	EtapaMedida(EtapaMemoria etapa) : previa(ContadorMemoria::etapaHilo) { ContadorMemoria::etapaHilo = etapa; }
+	~EtapaMedida() { ContadorMemoria::etapaHilo = previa; }
+
+private:
+	EtapaMemoria previa;
+};
+
+#ifdef TF_CONTAR_MEMORIA
+#define MEDIR_MEMORIA_CONCAT(a, b) a##b
+#define MEDIR_MEMORIA_NOMBRE(linea) MEDIR_MEMORIA_CONCAT(etapaMedida_, linea)
+#define MEDIR_MEMORIA(etapa) EtapaMedida MEDIR_MEMORIA_NOMBRE(__LINE__)(etapa)
+#else
+#define MEDIR_MEMORIA(etapa) do {} while(0)
+#endif
@@ -0,0 +1,107 @@
+/*
+--------------------------------------------------------------
+ controlCalidad.cpp
+
+ Implementación de la clase ControlCalidad
+--------------------------------------------------------------
+*/
+
+#include "controlCalidad.h"
+
+// círculos, escala del FBO, estelas, frames entre redibujos del GUI
+const NivelCalidad ControlCalidad::niveles[NUM_NIVELES] = {
+	{ 20, 1.00f, 1.00f, 1 },    // el de siempre (20 es la resolución por defecto)
+	{ 16, 1.00f, 0.75f, 2 },
+	{ 12, 0.75f, 0.50f, 4 },
+	{ 10, 0.50f, 0.50f, 8 },
+	{  8, 0.50f, 0.25f, 15 }
+};
+
+/*
+--------------------------------------------------------------
+ medir(milisegundos)
+ Promedio móvil exponencial (unos 10 frames) y cuenta de frames
+ seguidos de cada lado. Después de cambiar de nivel las cuentas
+ vuelven a cero: el nivel nuevo se mide entero antes de moverse otra vez.
+--------------------------------------------------------------
+*/
+
+bool ControlCalidad::medir(float milisegundos)
+{
+	promedio = promedio == 0 ? milisegundos : promedio + 0.1f * (milisegundos - promedio);
+	if(!activo) return false;
+
+	if(promedio > presupuesto * UMBRAL_BAJAR) { framesAlto++; framesBajo = 0; }
+	else if(promedio < presupuesto * UMBRAL_SUBIR) { framesBajo++; framesAlto = 0; }
+	else framesAlto = framesBajo = 0;
+
+	int anterior = nivel.load();
+	int nuevo = anterior;
+	if(framesAlto >= FRAMES_BAJAR && anterior < NUM_NIVELES - 1) nuevo = anterior + 1;
+	if(framesBajo >= FRAMES_SUBIR && anterior > 0) nuevo = anterior - 1;
+	if(nuevo == anterior) return false;
+
+	nivel = nuevo;
+	framesAlto = framesBajo = 0;
+	return true;
+}
+
+/*
+--------------------------------------------------------------
+ empezarGpu() / terminarGpu()
+ GL_TIME_ELAPSED alrededor de draw(). Al empezar se recogen, de la
+ más vieja a la más nueva, las consultas cuyo resultado ya está: no
+ se espera nunca a la GPU. Si las tres siguen en vuelo (la GPU va
+ atrasada) ese frame no se mide. Sin OpenGL 3.3 ni ARB_timer_query
+ (o en OpenGL ES) no se mide la GPU.
+--------------------------------------------------------------
+*/
+
+void ControlCalidad::empezarGpu()
+{
+#ifndef TARGET_OPENGLES
+	if(hayConsultas < 0) {
+		hayConsultas = ofIsGLProgrammableRenderer() || ofGLCheckExtension("GL_ARB_timer_query");
+		if(hayConsultas) glGenQueries(CONSULTAS, consultas);
+		else ofLogNotice("ControlCalidad") << "sin consultas de tiempo de OpenGL: solo se mide la CPU";
+	}
+	if(!hayConsultas) return;
+	
+	for(int k = 0; k < CONSULTAS; k++) {
+		int i = (consultaActual + k) % CONSULTAS;
+		if(!pendiente[i]) continue;
+		GLint listo = 0;
+		glGetQueryObjectiv(consultas[i], GL_QUERY_RESULT_AVAILABLE, &listo);
+		if(!listo) continue;
+		GLuint64 nanos = 0;
+		glGetQueryObjectui64v(consultas[i], GL_QUERY_RESULT, &nanos);
+		milisegundosGpu = nanos / 1000000.0f;
+		pendiente[i] = false;
+	}
+	
+	if(pendiente[consultaActual]) return;
+	glBeginQuery(GL_TIME_ELAPSED, consultas[consultaActual]);
+	midiendo = true;
+#endif
+}
+
+void ControlCalidad::terminarGpu()
+{
+#ifndef TARGET_OPENGLES
+	if(!midiendo) return;
+	glEndQuery(GL_TIME_ELAPSED);
+	pendiente[consultaActual] = true;
+	consultaActual = (consultaActual + 1) % CONSULTAS;
+	midiendo = false;
+#endif
+}
+
+string ControlCalidad::describir()
+{
+	const NivelCalidad& n = actual();
+	return "Calidad " + ofToString(getNivel()) + "/" + ofToString(NUM_NIVELES - 1) +
+		   " (" + ofToString(promedio, 1) + " de " + ofToString(presupuesto, 1) + " ms): círculos " +
+		   ofToString(n.resolucionCirculo) + ", FBO " + ofToString((int)(n.escalaFbo * 100)) +
+		   " %, estelas " + ofToString((int)(n.largoEstela * 100)) + " %, GUI cada " +
+		   ofToString(n.framesInterfaz) + " frames";
+}
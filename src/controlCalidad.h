@@ -0,0 +1,95 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+
+/*
+--------------------------------------------------------------
+ controlCalidad.h
+
+ Clase ControlCalidad
+
+ Sostiene el presupuesto de tiempo del frame (por defecto 16.6 ms)
+ bajando la calidad de lo que solo se ve, nunca de lo que suena:
+ la simulación, los tiempos de las notas y el MIDI no se tocan.
+
+ Cada frame ofApp le pasa el costo del frame: lo que tardaron
+ update() y draw() en la CPU, lo que tardó draw() en la GPU (con
+ consultas de tiempo de OpenGL, si el driver las tiene) y, si el
+ frame llegó tarde, el intervalo real entre frames. Así también se
+ ve un cuello de botella en la GPU, que la CPU no nota. Con un
+ promedio móvil de ese costo:
+   - si pasa el 90 % del presupuesto durante medio segundo, baja
+     un nivel;
+   - si queda debajo del 60 % durante tres segundos, sube uno.
+ Los dos umbrales separados y las esperas distintas (bajar rápido,
+ subir despacio) son la histéresis: un costo que ronda el límite
+ no hace saltar la calidad de un nivel a otro en cada frame.
+
+ Cada nivel fija:
+   - resolución de los círculos (ofSetCircleResolution),
+   - escala del FBO de las pelotas (lo que después se pixela),
+   - fracción del largo de las estelas,
+   - cada cuántos frames se puede redibujar la capa del GUI.
+ El nivel 0 es la imagen de siempre.
+--------------------------------------------------------------
+*/
+
+struct NivelCalidad {
+	int resolucionCirculo;
+	float escalaFbo;
+	float largoEstela;
+	int framesInterfaz;
+};
+
+class ControlCalidad
+{
+public:
+	static const int NUM_NIVELES = 5;
+
+	void setPresupuesto(float milisegundos) { presupuesto = milisegundos; }
+	float getPresupuesto() { return presupuesto; }
+
+	// Apagado se queda en el nivel 0 (--test-alloc, para que la escena no cambie)
+	void setActivo(bool a) { activo = a; if(!activo) nivel = 0; }
+
+	// Costo del frame en ms (hilo del GUI). Devuelve true si cambió el nivel.
+	bool medir(float milisegundos);
+	
+	// Tiempo de GPU de lo que se dibuja entre las dos llamadas (hilo del GUI).
+	// El resultado llega uno o dos frames después, sin esperar a la GPU;
+	// getMilisegundosGpu() da el último que llegó (0 si no hay consultas).
+	void empezarGpu();
+	void terminarGpu();
+	float getMilisegundosGpu() { return milisegundosGpu; }
+
+	// Nivel actual y lo que implica (cualquier hilo)
+	int getNivel() { return nivel.load(); }
+	const NivelCalidad& actual() { return niveles[nivel.load()]; }
+	float getPromedio() { return promedio; }
+
+	string describir();
+
+private:
+	static const NivelCalidad niveles[NUM_NIVELES];
+
+	static constexpr float UMBRAL_BAJAR = 0.9f;   // fracción del presupuesto
+	static constexpr float UMBRAL_SUBIR = 0.6f;
+	static const int FRAMES_BAJAR = 30;
+	static const int FRAMES_SUBIR = 180;
+
+	float presupuesto = 1000.0f / 60.0f;
+	bool activo = true;
+	std::atomic<int> nivel{0};
+	float promedio = 0;
+	int framesAlto = 0;     // frames seguidos arriba del umbral de bajar
+	int framesBajo = 0;     // frames seguidos debajo del umbral de subir
+	
+	// Consultas de tiempo de OpenGL, en anillo: una por frame en vuelo
+	static const int CONSULTAS = 3;
+	GLuint consultas[CONSULTAS] = {0};
+	bool pendiente[CONSULTAS] = {false};
+	int consultaActual = 0;
+	int hayConsultas = -1;  // -1 = todavía no se preguntó al driver
+	bool midiendo = false;
+	float milisegundosGpu = 0;
+};
@@ -15,6 +15,7 @@
 */
 
 # include "controlGui.h"
+# include "registro.h"
 
 
 /*
@@ -74,12 +75,21 @@ void Controles::setup(ofxPanel& gui, MidiSender* midiCh)
 	efectos.add(record.setup     ("Grabar (g)", false));          // Comienzo y detención de la grabación en Ableton
 	
 	gui.add(&efectos);
+	
+    // Banco de presets: teclas 1..0 o Program Change, 'u' + número guarda
+	presets.setup("Presets");
+	presets.add(morph.setup("Morph seg (1..0)", 2, 0, 10));   // 0 = cambio instantáneo
+	
+	gui.add(&presets);
 }
 
 /*
 --------------------------------------------------------------
-update()
+update(par)
  Envía valores MIDI CC en cada frame, mapeados desde sliders.
+ Lee la copia publicada de los parámetros (no los sliders), así puede
+ correr en el hilo de simulación. Solo se miran los parámetros marcados
+ como cambiados, y solo salen al cable los CC cuyo valor cambió.
  el primer número entre parentesis es el continous controller asginado para controlar
  y el segundo es el valor que mandamos.
  el control de gain de distorsión y está asignado al #cc29 y el slider manda valores entre 0 y 11
@@ -87,16 +97,65 @@ update()
 --------------------------------------------------------------
 */
 
-void Controles::update()
+void Controles::update(const Parametros& par)
 {
-	midi->sendControlChange(29, ofMap( distorsion, 0.0, 11, 0, 127 ));
-	midi->sendControlChange(30, ofMap(filtro, 0, 100, 0, 127));
-	midi->sendControlChange(31, ofMap( ataque, 0.0, 20, 0, 127 ));
-	midi->sendControlChange(32, ofMap(release, 0.0, 60, 0, 127 ));
-	midi->sendControlChange(33, ofMap(reverb, 0, 100, 0, 127 ));
-	midi->sendControlChange(34, ofMap(delay, 0, 100, 0, 127 ));
-	midi->sendControlChange(35, ofMap(tiempo, 0, 2500, 0, 127 ));
-	midi->sendControlChange(36, ofMap(feedback, 0, 150, 0, 127 ));
+	if(par.cambio(PARAM_DISTORSION)) midi->sendControlChangeSiCambia(29, ofMap(par.get(PARAM_DISTORSION), 0.0, 11, 0, 127 ));
+	if(par.cambio(PARAM_FILTRO))     midi->sendControlChangeSiCambia(30, ofMap(par.get(PARAM_FILTRO), 0, 100, 0, 127));
+	if(par.cambio(PARAM_ATAQUE))     midi->sendControlChangeSiCambia(31, ofMap(par.get(PARAM_ATAQUE), 0.0, 20, 0, 127 ));
+	if(par.cambio(PARAM_RELEASE))    midi->sendControlChangeSiCambia(32, ofMap(par.get(PARAM_RELEASE), 0.0, 60, 0, 127 ));
+	if(par.cambio(PARAM_REVERB))     midi->sendControlChangeSiCambia(33, ofMap(par.get(PARAM_REVERB), 0, 100, 0, 127 ));
+	if(par.cambio(PARAM_DELAY))      midi->sendControlChangeSiCambia(34, ofMap(par.get(PARAM_DELAY), 0, 100, 0, 127 ));
+	if(par.cambio(PARAM_TIEMPO))     midi->sendControlChangeSiCambia(35, ofMap(par.get(PARAM_TIEMPO), 0, 2500, 0, 127 ));
+	if(par.cambio(PARAM_FEEDBACK))   midi->sendControlChangeSiCambia(36, ofMap(par.get(PARAM_FEEDBACK), 0, 150, 0, 127 ));
+}
+
+
+/*
+--------------------------------------------------------------
+capturar(par) / publicar() / leerParametros()
+
+ capturar copia cada slider y toggle a un bloque plano de números.
+ publicar, una vez por frame desde el hilo del GUI, compara la copia
+ con la anterior, marca en "cambios" los parámetros que se movieron
+ y la entrega por el triple buffer. Si la copia anterior se pisó sin
+ que la simulación la leyera, sus cambios pasan a la siguiente, así
+ ningún cambio se pierde.
+ leerParametros devuelve la última copia completa, desde cualquier hilo
+ de trabajo (uno solo a la vez), sin bloquear al GUI.
+--------------------------------------------------------------
+*/
+
+void Controles::capturar(Parametros& par)
+{
+	for(int id = 0; id < NUM_PARAMETROS; id++)
+		par.valores[id] = getParametro(id);
+}
+
+void Controles::publicar()
+{
+	Parametros& par = publicados.escritura();
+	capturar(par);
+	
+	uint32_t nuevos = 0;
+	for(int id = 0; id < NUM_PARAMETROS; id++) {
+		if(version == 0 || par.valores[id] != ultimosValores[id])
+			nuevos |= 1u << id;   // la primera copia marca todo
+		ultimosValores[id] = par.valores[id];
+	}
+	
+	cambiosSinLeer |= nuevos;
+	par.cambios = cambiosSinLeer;
+	par.version = ++version;
+	
+	// Si la anterior se leyó, lo que llevaba ya llegó: queda pendiente solo lo de
+	// esta copia, que puede pisarse en el próximo frame. Si se pisó, sigue todo.
+	if(!publicados.publicar())
+		cambiosSinLeer = nuevos;
+}
+
+const Parametros& Controles::leerParametros()
+{
+	return publicados.lectura();
 }
 
 
@@ -134,7 +193,7 @@ int Controles::escalas(int nroNota, float radioRefe)
 	
 	int gradoIndex = (int)ofMap(radioRefe, 10.0f, 50.0f, totalGrados-1, 0, true);
 	int octava = gradoIndex / 7;        // divido por 7 porque esos 42 grados son 7 por octava
-	int grado = gradoIndex % 7;         // me va a dar el grado, entre 0 y 7.
+	int grado = gradoEscala(radioRefe); // me va a dar el grado, entre 0 y 7.
 
 	switch (nroNota){
 			
@@ -148,6 +207,14 @@ int Controles::escalas(int nroNota, float radioRefe)
 	return nota;
 }
 
+// Grado de la escala (0..6) que le toca a un radio, el mismo que usa escalas()
+int Controles::gradoEscala(float radioRefe)
+{
+	int totalGrados = 6 * 7;
+	int gradoIndex = (int)ofMap(radioRefe, 10.0f, 50.0f, totalGrados-1, 0, true);
+	return gradoIndex % 7;
+}
+
 
 /*
 --------------------------------------------------------------
@@ -236,13 +303,12 @@ void Controles::teclado(int key)
 //--------------------------------------------------------------
 // infoPelotas()
 //  Imprime en consola información de depuración sobre cada pelota creada.
+//  Pasa por el registro asincrónico: no arma strings en este hilo.
 //--------------------------------------------------------------
 void Controles::infoPelotas(int i, float radio, int nota)
 {
-	ofLogNotice() << "Pelota " << i + 1
-				  << " | radio: " << radio
-				  << " -> nota: " << nota << " = "
-				  << nombreNotas(nota);
+	REGISTRO_NOTICE("Pelota {} | radio: {} -> nota: {} = {}{}",
+					i + 1, radio, nota, nombreNota(nota), nota/12 - 1);
 }
 
 //--------------------------------------------------------------
@@ -253,14 +319,28 @@ void Controles::infoPelotas(int i, float radio, int nota)
 void Controles::nombreEscalas(int nombre)
 {
 	switch(nombre){
-		case 0: ofLogNotice() << "Escala Cromática"; break;
-		case 1: ofLogNotice() << "Escala Diatonica"; break;
-		case 2: ofLogNotice() << "Escala Menor Melódica"; break;
-		case 3: ofLogNotice() << "Escala Menor Armónica"; break;
-		case 4: ofLogNotice() << "Escala Mayor Armónica"; break;
+		case 0: REGISTRO_NOTICE("Escala Cromática"); break;
+		case 1: REGISTRO_NOTICE("Escala Diatonica"); break;
+		case 2: REGISTRO_NOTICE("Escala Menor Melódica"); break;
+		case 3: REGISTRO_NOTICE("Escala Menor Armónica"); break;
+		case 4: REGISTRO_NOTICE("Escala Mayor Armónica"); break;
 	}
 }
 
+//--------------------------------------------------------------
+// nombreNota()
+//  Nombre de la nota sin octava (Do, Do#, Re...). Devuelve un texto
+//  estático, así se puede pasar al registro sin copiarlo.
+//--------------------------------------------------------------
+const char* Controles::nombreNota(int nota)
+{
+	static const char* nombres[12] = {
+		"Do", "Do#", "Re", "Re#", "Mi", "Fa", "Fa#", "Sol", "Sol#", "La", "La#", "Si"
+	};
+	if(nota < 0) return "?";
+	return nombres[nota % 12];
+}
+
 //--------------------------------------------------------------
 // nombreNotas()
 //  Le asigna al número de la nota MIDI su respectiva nota musical (Do, Re, Mi...)
@@ -290,12 +370,84 @@ string Controles::nombreNotas(int nota)
 //--------------------------------------------------------------
 // mensaje()
 // Imprime en la pantalla una cadena de texto con información de utilidad.
+// El texto se arma una sola vez: redibujar la info no pide memoria por él.
 //--------------------------------------------------------------
 
-string Controles::mensaje()
+const string& Controles::mensaje()
 {
-	return ("'Barra Espaciadora' Para generar pelotas, 'n' o 'N' Para matarlas!!!\n"
+	static const string texto("'Barra Espaciadora' Para generar pelotas, 'n' o 'N' Para matarlas!!!\n"
 			"'x' Guarda preset actual, 'b' Carga presets \n"
 			"'z' Oculta Panel GUI,     'i' Oculta esta info\n"
+			"'1'..'0' Llama un preset del banco, 'u' + numero lo guarda\n"
+			"'h' Simula en un hilo aparte (on/off)\n"
+			"'m' Dibuja obstaculos (circulo/segmento/poligono), 'M' borra el ultimo\n"
 	);
+	return texto;
+}
+
+//--------------------------------------------------------------
+// getParametro() / setParametro()
+//  Acceso a los sliders y toggles por identificador, para quien
+//  controla la aplicación desde afuera (OSC, presets).
+//  setParametro recorta el valor al rango del slider; en los toggles
+//  cualquier valor mayor o igual a 0.5 es "encendido".
+//--------------------------------------------------------------
+
+float Controles::getParametro(int id)
+{
+	switch(id) {
+		case PARAM_RANGO_RANDOM: return rangoRandom;
+		case PARAM_TIPO_ESCALA:  return tipoDeEscala;
+		case PARAM_FACTOR_VITAL: return factorVital;
+		case PARAM_FACTOR_VEL:   return factorVel;
+		case PARAM_RANDOM:       return random ? 1 : 0;
+		case PARAM_REGENERACION: return regeneracion ? 1 : 0;
+		case PARAM_SUMAR:        return sumar ? 1 : 0;
+		case PARAM_CENTRO:       return centro ? 1 : 0;
+		case PARAM_ACORDES:      return acordes ? 1 : 0;
+		case PARAM_ATAQUE:       return ataque;
+		case PARAM_RELEASE:      return release;
+		case PARAM_DISTORSION:   return distorsion;
+		case PARAM_FILTRO:       return filtro;
+		case PARAM_DELAY:        return delay;
+		case PARAM_TIEMPO:       return tiempo;
+		case PARAM_FEEDBACK:     return feedback;
+		case PARAM_REVERB:       return reverb;
+		default: return 0;
+	}
+}
+
+void Controles::setParametro(int id, float valor)
+{
+	switch(id) {
+		case PARAM_RANGO_RANDOM: rangoRandom  = ofClamp(valor, rangoRandom.getMin(), rangoRandom.getMax()); break;
+		case PARAM_TIPO_ESCALA:  tipoDeEscala = ofClamp(valor, tipoDeEscala.getMin(), tipoDeEscala.getMax()); break;
+		case PARAM_FACTOR_VITAL: factorVital  = ofClamp(valor, factorVital.getMin(), factorVital.getMax()); break;
+		case PARAM_FACTOR_VEL:   factorVel    = ofClamp(valor, factorVel.getMin(), factorVel.getMax()); break;
+		case PARAM_RANDOM:       random       = valor >= 0.5f; break;
+		case PARAM_REGENERACION: regeneracion = valor >= 0.5f; break;
+		case PARAM_SUMAR:        sumar        = valor >= 0.5f; break;
+		case PARAM_CENTRO:       centro       = valor >= 0.5f; break;
+		case PARAM_ACORDES:      acordes      = valor >= 0.5f; break;
+		case PARAM_ATAQUE:       ataque       = ofClamp(valor, ataque.getMin(), ataque.getMax()); break;
+		case PARAM_RELEASE:      release      = ofClamp(valor, release.getMin(), release.getMax()); break;
+		case PARAM_DISTORSION:   distorsion   = ofClamp(valor, distorsion.getMin(), distorsion.getMax()); break;
+		case PARAM_FILTRO:       filtro       = ofClamp(valor, filtro.getMin(), filtro.getMax()); break;
+		case PARAM_DELAY:        delay        = ofClamp(valor, delay.getMin(), delay.getMax()); break;
+		case PARAM_TIEMPO:       tiempo       = ofClamp(valor, tiempo.getMin(), tiempo.getMax()); break;
+		case PARAM_FEEDBACK:     feedback     = ofClamp(valor, feedback.getMin(), feedback.getMax()); break;
+		case PARAM_REVERB:       reverb       = ofClamp(valor, reverb.getMin(), reverb.getMax()); break;
+	}
+}
+
+const char* Controles::nombreParametro(int id)
+{
+	static const char* nombres[NUM_PARAMETROS] = {
+		"rangoRandom", "tipoDeEscala", "factorVital", "factorVel",
+		"random", "regeneracion", "sumar", "centro", "acordes",
+		"ataque", "release", "distorsion", "filtro", "delay",
+		"tiempo", "feedback", "reverb"
+	};
+	if(id < 0 || id >= NUM_PARAMETROS) return "";
+	return nombres[id];
 }
@@ -2,6 +2,8 @@
 #include "ofMain.h"
 #include "MidiSender.h"
 #include "ofxGui.h"
+#include "tripleBuffer.h"
+#include "parametros.h"
 
 /*
 --------------------------------------------------------------
@@ -27,6 +29,14 @@
    2 - Escala menor melódica
    3 - Escala menor armónica
    4 - Escala mayor armónica
+
+ Los parámetros que pueden controlarse desde afuera (OSC, presets)
+ se identifican con ParametroId (ver parametros.h), y se leen o escriben
+ con getParametro() / setParametro() respetando el rango de cada slider.
+ 
+ Los sliders solo se leen desde el hilo del GUI. Una vez por frame
+ publicar() deja una copia plana (Parametros) para los hilos de trabajo,
+ que la toman con leerParametros() sin bloquearse.
 --------------------------------------------------------------
 */
 
@@ -36,11 +46,21 @@ public:
 	// Inicializa paneles y parámetros GUI
 	void setup(ofxPanel& gui, MidiSender* midi);
 	
-	// Actualiza valores MIDI CC segun la posición de los sliders
-	void update();
+	// Actualiza valores MIDI CC segun la copia de parámetros (solo los que cambiaron)
+	void update(const Parametros& par);
+	
+	// Copia los sliders y toggles a un bloque plano (solo desde el hilo del GUI)
+	void capturar(Parametros& par);
+	
+	// Publica la copia del frame para los hilos de trabajo (una vez por frame, hilo del GUI)
+	void publicar();
+	
+	// Última copia publicada (desde el hilo de trabajo; sin bloqueo)
+	const Parametros& leerParametros();
 	
 	// Cálculo de notas MIDI segun la escala y el radio de las pelotas
 	int escalas(int nroNota, float radioRefe);
+	static int gradoEscala(float radioRefe);   // grado (0..6) que escalas() usa para ese radio
 	
 	// manejo del teclado para el control de parámetros
 	void teclado(int key);
@@ -53,9 +73,17 @@ public:
 	
 	// Convierte el número MIDI en nota musical
 	string nombreNotas(int nota);
+	static const char* nombreNota(int nota);   // sin octava, texto estático
 	
 	// Mensaje informativo dibujado en pantalla
-	string mensaje();
+	const string& mensaje();
+	
+	// Acceso genérico a los parámetros por identificador (ver ParametroId)
+	float getParametro(int id);
+	void setParametro(int id, float valor);
+	
+	// Nombre corto de cada parámetro, el mismo que el de la variable miembro
+	static const char* nombreParametro(int id);
 	
 	// ELEMENTOS DE GUI
 	
@@ -76,6 +104,8 @@ public:
 	ofxFloatSlider delay;
 	ofxFloatSlider feedback;
 	ofxFloatSlider filtro;
+	ofxGuiGroup presets;      // Grupo del banco de presets
+	ofxFloatSlider morph;     // segundos de interpolación al cambiar de preset
 	
 	// Getters
 	float getDistorsion() { return distorsion; }
@@ -93,5 +123,11 @@ public:
 private:
 	MidiSender* midi;  // MIDI:puntero que apunta al canal activo
 	
+	// Copias publicadas de los parámetros (GUI -> hilos de trabajo)
+	TripleBuffer<Parametros> publicados;
+	float ultimosValores[NUM_PARAMETROS];   // lo último publicado, para marcar cambios
+	uint32_t cambiosSinLeer = 0;            // cambios publicados que la simulación todavía no leyó
+	uint64_t version = 0;
+	
 };
 
@@ -0,0 +1,37 @@
+/*
+--------------------------------------------------------------
+ cronometroArranque.cpp
+
+ Implementación de la clase CronometroArranque
+--------------------------------------------------------------
+*/
+
+#include "cronometroArranque.h"
+
+void CronometroArranque::iniciar()
+{
+	inicio = ofGetSystemTimeMicros();
+	fases.reserve(16);
+}
+
+void CronometroArranque::marcar(const char* fase)
+{
+	if(informado) return;
+	if(inicio == 0) iniciar();    // sin main(): se cuenta desde la primera marca
+	fases.push_back({ fase, ofGetSystemTimeMicros() - inicio });
+}
+
+void CronometroArranque::primerFrame()
+{
+	if(informado) return;
+	marcar("primer frame");
+	informado = true;
+	
+	uint64_t anterior = 0;
+	for(auto& fase : fases) {
+		ofLogNotice("Arranque") << ofToString((fase.fin - anterior) / 1000.0f, 1) << " ms  " << fase.nombre;
+		anterior = fase.fin;
+	}
+	milisPrimerFrame = fases.back().fin / 1000.0f;
+	ofLogNotice("Arranque") << "Tiempo hasta el primer frame: " << ofToString(milisPrimerFrame, 1) << " ms";
+}
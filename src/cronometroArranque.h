@@ -0,0 +1,45 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ cronometroArranque.h
+
+ Clase CronometroArranque
+
+ Mide cuánto tarda cada fase del arranque, desde main() hasta el
+ primer frame dibujado (tiempo hasta el primer frame), y lo informa
+ una sola vez en la consola:
+
+   main -> ventana -> fases de setup() -> primer frame
+
+ Lo que se hace en segundo plano (puertos MIDI, audio) no cuenta:
+ lo mide DescubridorDispositivos aparte.
+--------------------------------------------------------------
+*/
+
+class CronometroArranque
+{
+public:
+	// Desde main(), antes de crear la ventana
+	void iniciar();
+	
+	// Termina una fase (el nombre tiene que ser un literal)
+	void marcar(const char* fase);
+	
+	// Desde draw(): la primera vez marca el primer frame e informa
+	void primerFrame();
+	
+	float getMilisPrimerFrame() { return milisPrimerFrame; }
+	
+private:
+	struct Fase {
+		const char* nombre;
+		uint64_t fin;      // micros desde iniciar()
+	};
+	
+	uint64_t inicio = 0;
+	vector<Fase> fases;
+	bool informado = false;
+	float milisPrimerFrame = 0;
+};
@@ -0,0 +1,157 @@
+/*
+--------------------------------------------------------------
+ descubridorDispositivos.cpp
+
+ Implementación de la clase DescubridorDispositivos
+--------------------------------------------------------------
+*/
+
+#include "descubridorDispositivos.h"
+
+void DescubridorDispositivos::iniciar(float segundosEntreBusquedas)
+{
+	intervalo = segundosEntreBusquedas;
+	startThread();
+}
+
+void DescubridorDispositivos::encargar(const string& nombre, std::function<void()> tarea, float segundosLimite)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutexDatos);
+		tareas.push_back({ nombre, tarea, segundosLimite });
+	}
+	aviso.notify_all();
+}
+
+void DescubridorDispositivos::alCambiar(std::function<void()> funcion)
+{
+	std::lock_guard<std::mutex> lock(mutexDatos);
+	funcionesCambio.push_back(funcion);
+}
+
+string DescubridorDispositivos::nombreSalida(int puerto)
+{
+	std::lock_guard<std::mutex> lock(mutexDatos);
+	return puerto >= 0 && puerto < (int)salidas.size() ? salidas[puerto] : "";
+}
+
+string DescubridorDispositivos::nombreEntrada(int puerto)
+{
+	std::lock_guard<std::mutex> lock(mutexDatos);
+	return puerto >= 0 && puerto < (int)entradas.size() ? entradas[puerto] : "";
+}
+
+/*
+--------------------------------------------------------------
+ threadedFunction()
+ Primero la búsqueda de puertos (la necesitan los escritores MIDI),
+ después las tareas encargadas, y de ahí en más una búsqueda cada
+ "intervalo" segundos o antes si llega una tarea nueva.
+--------------------------------------------------------------
+*/
+
+void DescubridorDispositivos::threadedFunction()
+{
+	correr({ "Búsqueda de puertos MIDI", [this]{ buscar(); }, 3.0f });
+	uint64_t proximaBusqueda = ofGetElapsedTimeMillis() + intervalo * 1000;
+	
+	while(isThreadRunning()) {
+		Tarea tarea;
+		bool hayTarea = false;
+		{
+			std::unique_lock<std::mutex> lock(mutexDatos);
+			uint64_t ahora = ofGetElapsedTimeMillis();
+			if(tareas.empty() && ahora < proximaBusqueda)
+				aviso.wait_for(lock, std::chrono::milliseconds(proximaBusqueda - ahora));
+			if(!isThreadRunning()) break;
+			if(!tareas.empty()) {
+				tarea = tareas.front();
+				tareas.pop_front();
+				hayTarea = true;
+			}
+		}
+		
+		if(hayTarea)
+			correr(tarea);
+		
+		if(ofGetElapsedTimeMillis() >= proximaBusqueda) {
+			buscar();
+			proximaBusqueda = ofGetElapsedTimeMillis() + intervalo * 1000;
+		}
+	}
+}
+
+// Corre una tarea midiendo cuánto tarda
+void DescubridorDispositivos::correr(const Tarea& tarea)
+{
+	uint64_t inicio = ofGetElapsedTimeMicros();
+	{
+		std::lock_guard<std::mutex> lock(mutexDatos);
+		nombreEnCurso = tarea.nombre;
+		limiteEnCurso = tarea.segundosLimite;
+		inicioEnCurso = inicio;
+		demoraAvisada = false;
+	}
+	
+	tarea.funcion();
+	
+	float segundos = (ofGetElapsedTimeMicros() - inicio) / 1e6f;
+	{
+		std::lock_guard<std::mutex> lock(mutexDatos);
+		inicioEnCurso = 0;
+	}
+	// el nombre no es estático: va por ofLog y no por el registro
+	if(segundos > tarea.segundosLimite)
+		ofLogWarning("DescubridorDispositivos") << tarea.nombre << " terminó tarde: " << segundos << " s";
+	else
+		ofLogNotice("DescubridorDispositivos") << tarea.nombre << " listo en " << ofToString(segundos * 1000, 1) << " ms";
+}
+
+void DescubridorDispositivos::revisarDemoras()
+{
+	std::unique_lock<std::mutex> lock(mutexDatos, std::try_to_lock);
+	if(!lock.owns_lock() || inicioEnCurso == 0 || demoraAvisada) return;
+	
+	float segundos = (ofGetElapsedTimeMicros() - inicioEnCurso) / 1e6f;
+	if(segundos > limiteEnCurso) {
+		demoraAvisada = true;
+		ofLogWarning("DescubridorDispositivos") << nombreEnCurso << " lleva " << ofToString(segundos, 1)
+												<< " s (límite " << limiteEnCurso << " s): se sigue sin ese dispositivo";
+	}
+}
+
+// Lista los puertos; si algo cambió, sube la versión y avisa
+void DescubridorDispositivos::buscar()
+{
+	vector<string> nuevasSalidas = buscadorSalidas.getOutPortList();
+	vector<string> nuevasEntradas = buscadorEntradas.getInPortList();
+	
+	vector<std::function<void()>> avisar;
+	{
+		std::lock_guard<std::mutex> lock(mutexDatos);
+		if(version.load() != 0 && nuevasSalidas == salidas && nuevasEntradas == entradas)
+			return;
+		salidas = nuevasSalidas;
+		entradas = nuevasEntradas;
+		version++;
+		avisar = funcionesCambio;
+	}
+	
+	for(size_t i = 0; i < nuevasSalidas.size(); i++)
+		ofLogNotice("DescubridorDispositivos") << "Salida MIDI " << i << ": " << nuevasSalidas[i];
+	for(size_t i = 0; i < nuevasEntradas.size(); i++)
+		ofLogNotice("DescubridorDispositivos") << "Entrada MIDI " << i << ": " << nuevasEntradas[i];
+	for(auto& funcion : avisar)
+		funcion();
+}
+
+void DescubridorDispositivos::exit()
+{
+	{
+		// bajo el mutex, para que el hilo no se duerma justo después del aviso
+		std::lock_guard<std::mutex> lock(mutexDatos);
+		stopThread();
+	}
+	aviso.notify_all();
+	waitForThread(false);
+}
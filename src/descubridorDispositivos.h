@@ -0,0 +1,84 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxMidi.h"
+
+/*
+--------------------------------------------------------------
+ descubridorDispositivos.h
+
+ Clase DescubridorDispositivos
+
+ Todo lo que tiene que ver con buscar y abrir dispositivos pasa en
+ este hilo, nunca en el del GUI. Listar los puertos MIDI puede tardar
+ segundos en una máquina con muchos puertos virtuales, y abrir la
+ placa de sonido también.
+
+   - Cada segundosEntreBusquedas lista los puertos MIDI de entrada y
+     salida. Si la lista cambió (se enchufó o desenchufó algo), sube
+     la versión y llama a las funciones registradas con alCambiar().
+   - encargar() deja una tarea de inicio (abrir el audio, la entrada
+     MIDI) para correr en este hilo, de a una, midiendo cuánto tardó.
+     Si una tarea pasa su tiempo límite se avisa (revisarDemoras(), que
+     ofApp llama en cada frame); no se la puede cortar, pero tampoco
+     frena a nadie.
+   - Los escritores MIDI preguntan acá si su puerto existe (barato:
+     solo leen la versión) y mientras no existe descartan lo que les
+     llega, como un sumidero nulo.
+--------------------------------------------------------------
+*/
+
+class DescubridorDispositivos : public ofThread
+{
+public:
+	// Arranca el hilo. La primera búsqueda empieza enseguida.
+	void iniciar(float segundosEntreBusquedas = 2.0f);
+	
+	// Tarea de inicio para correr en este hilo (no bloquea)
+	void encargar(const string& nombre, std::function<void()> tarea, float segundosLimite = 3.0f);
+	
+	// Función que se llama (en este hilo) cada vez que cambia la lista de puertos
+	void alCambiar(std::function<void()> funcion);
+	
+	// Cambia cada vez que cambia la lista de puertos (0 = todavía no se buscó)
+	uint32_t getVersion() { return version.load(); }
+	
+	// Nombre del puerto, o "" si no existe (cualquier hilo)
+	string nombreSalida(int puerto);
+	string nombreEntrada(int puerto);
+	
+	// Avisa una vez si la tarea en curso pasó su límite (hilo del GUI, no bloquea)
+	void revisarDemoras();
+	
+	void exit();
+	
+private:
+	void threadedFunction();
+	void buscar();
+	
+	struct Tarea {
+		string nombre;
+		std::function<void()> funcion;
+		float segundosLimite;
+	};
+	
+	void correr(const Tarea& tarea);
+	
+	// Tarea en curso, para revisarDemoras()
+	string nombreEnCurso;
+	float limiteEnCurso = 0;
+	uint64_t inicioEnCurso = 0;    // micros, 0 = ninguna
+	bool demoraAvisada = false;
+	
+	float intervalo = 2.0f;
+	
+	std::mutex mutexDatos;
+	std::condition_variable aviso;
+	std::deque<Tarea> tareas;
+	vector<std::function<void()>> funcionesCambio;
+	vector<string> salidas;
+	vector<string> entradas;
+	std::atomic<uint32_t> version{0};
+	
+	ofxMidiOut buscadorSalidas;
+	ofxMidiIn buscadorEntradas;
+};
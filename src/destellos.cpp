@@ -0,0 +1,75 @@
+/*
+--------------------------------------------------------------
+ destellos.cpp
+
+ Implementación de la clase Destellos
+--------------------------------------------------------------
+*/
+
+#include "destellos.h"
+
+Destellos::Destellos()
+{
+	for(auto& d : anillo) d.inicio = 0, d.radio = 0;
+}
+
+void Destellos::agregar(float x, float y, float radio, const ofColor& color, uint64_t tick)
+{
+	Destello& d = anillo[proximo];
+	d.x = x;
+	d.y = y;
+	d.radio = radio;
+	d.color = color;
+	d.inicio = tick;
+	proximo = (proximo + 1) % MAX_DESTELLOS;
+}
+
+//--------------------------------------------------------------
+// procesar()
+// Rebotes en blanco, obstáculos con el color de su nota,
+// choques en amarillo y del tamaño de su impulso.
+//--------------------------------------------------------------
+
+void Destellos::procesar(const EventoSimulacion* eventos, int cantidad, uint64_t tick)
+{
+	for(int i = 0; i < cantidad; i++) {
+		const EventoSimulacion& e = eventos[i];
+		switch(e.tipo) {
+			case SIM_PARED:
+				agregar(e.x, e.y, 6, ofColor(255), tick);
+				break;
+
+			case SIM_OBSTACULO:
+				agregar(e.x, e.y, 8, e.nota >= 0 ? ofColor::fromHsb((e.nota * 8) % 360, 120, 255) : ofColor(255), tick);
+				break;
+
+			case SIM_CONTACTO:
+				agregar(e.x, e.y, ofClamp(e.valor, 4, 40), ofColor(255, 230, 120), tick);
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+// visual(inst, tick)
+// El radio crece al doble y la transparencia baja a cero en DURACION ticks
+//--------------------------------------------------------------
+
+void Destellos::visual(Instantanea& inst, uint64_t tick)
+{
+	inst.cantidadDestellos = 0;
+	for(const Destello& d : anillo) {
+		if(d.radio <= 0 || tick < d.inicio || tick - d.inicio >= DURACION) continue;
+
+		float edad = (float)(tick - d.inicio) / DURACION;
+		DestelloVisual& v = inst.destellos[inst.cantidadDestellos++];
+		v.x = d.x;
+		v.y = d.y;
+		v.radio = d.radio * (1 + edad);
+		v.color = d.color;
+		v.color.a = 200 * (1 - edad);
+	}
+}
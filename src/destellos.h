@@ -0,0 +1,46 @@
+#pragma once
+#include "ofMain.h"
+#include "busEventos.h"
+#include "instantanea.h"
+
+/*
+--------------------------------------------------------------
+ destellos.h
+
+ Clase Destellos
+
+ Suscriptor visual del bus de eventos: cada rebote contra una
+ pared u obstáculo, y cada choque entre pelotas, deja un anillo
+ que crece y se apaga en unos pocos ticks. Los choques más
+ fuertes (más impulso) dejan anillos más grandes.
+
+ Guarda los últimos MAX_DESTELLOS en un anillo fijo (los más
+ viejos se pisan) y los copia a la instantánea del tick.
+--------------------------------------------------------------
+*/
+
+class Destellos : public OyenteEventos {
+public:
+	static const int MAX_DESTELLOS = 128;
+	static const int DURACION = 15;        // ticks que dura un destello
+
+	Destellos();
+
+	void procesar(const EventoSimulacion* eventos, int cantidad, uint64_t tick) override;
+
+	// Copia a la instantánea los destellos que siguen vivos en "tick"
+	void visual(Instantanea& inst, uint64_t tick);
+
+private:
+	struct Destello {
+		float x, y;
+		float radio;          // radio inicial
+		uint64_t inicio;      // tick en que nació
+		ofColor color;
+	};
+
+	void agregar(float x, float y, float radio, const ofColor& color, uint64_t tick);
+
+	Destello anillo[MAX_DESTELLOS];
+	int proximo = 0;
+};
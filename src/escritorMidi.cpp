@@ -0,0 +1,174 @@
+/*
+--------------------------------------------------------------
+ escritorMidi.cpp
+
+ Implementación de la clase EscritorMidi
+--------------------------------------------------------------
+*/
+
+#include "escritorMidi.h"
+
+void EscritorMidi::abrir(int numeroPuerto, int numeroCanal, DescubridorDispositivos* d)
+{
+	puerto = numeroPuerto;
+	canal = numeroCanal;
+	descubridor = d;
+	startThread();
+}
+
+void EscritorMidi::encolar(MidiStatus estado, int dato1, int dato2)
+{
+	uint32_t f = fin.load(std::memory_order_relaxed);
+	if(f - cabeza.load(std::memory_order_acquire) >= CAPACIDAD) {
+		perdidos++;
+		return;
+	}
+	cola[f & (CAPACIDAD - 1)] = { estado, (uint8_t)dato1, (uint8_t)dato2 };
+	fin.store(f + 1, std::memory_order_release);
+}
+
+void EscritorMidi::despachar()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutexAviso);
+		hayAviso = true;
+	}
+	aviso.notify_one();
+}
+
+/*
+--------------------------------------------------------------
+ threadedFunction()
+ Duerme hasta el próximo despacho (o un rato, para notar si el
+ puerto aparece o desaparece) y escribe todo lo encolado.
+ Al detenerse vacía la cola, para que no quede ninguna nota colgada.
+--------------------------------------------------------------
+*/
+
+void EscritorMidi::threadedFunction()
+{
+	while(isThreadRunning()) {
+		{
+			std::unique_lock<std::mutex> lock(mutexAviso);
+			aviso.wait_for(lock, std::chrono::milliseconds(250), [this]{ return hayAviso || !isThreadRunning(); });
+			hayAviso = false;
+		}
+		revisarPuerto();
+		if(conectado)
+			escribirCola();
+		else
+			descartarCola();
+	}
+	if(conectado)
+		escribirCola();
+}
+
+/*
+--------------------------------------------------------------
+ revisarPuerto()
+ Solo hace algo cuando cambió la lista de puertos: cierra el puerto
+ si desapareció, y lo abre si apareció.
+--------------------------------------------------------------
+*/
+
+void EscritorMidi::revisarPuerto()
+{
+	uint32_t version = descubridor != nullptr ? descubridor->getVersion() : 1;
+	if(version == versionVista || version == 0) return;
+	versionVista = version;
+	
+	string nombre = descubridor != nullptr ? descubridor->nombreSalida(puerto) : "";
+	
+	if(conectado && nombre != nombreAbierto) {
+		midiOut.closePort();
+		conectado = false;
+		ofLogWarning("EscritorMidi") << "Se desconectó la salida MIDI " << puerto << " (" << nombreAbierto << ")";
+	}
+	
+	if(!conectado) {
+		if(descubridor != nullptr && nombre.empty()) {
+			ofLogWarning("EscritorMidi") << "No hay salida MIDI " << puerto << ": sus mensajes se descartan hasta que aparezca";
+			return;
+		}
+		conectado = descubridor != nullptr ? midiOut.openPort(nombre) : midiOut.openPort(puerto);
+		nombreAbierto = nombre;
+		if(conectado) {
+			ofLogNotice("EscritorMidi") << "Salida MIDI " << puerto << " abierta: " << nombre;
+			reconciliar();
+		}
+		else
+			ofLogError("EscritorMidi") << "No se pudo abrir la salida MIDI " << puerto;
+	}
+}
+
+// Sumidero nulo: sin puerto, lo encolado se descarta (pero se anota qué suena)
+void EscritorMidi::descartarCola()
+{
+	uint32_t c = cabeza.load(std::memory_order_relaxed);
+	uint32_t f = fin.load(std::memory_order_acquire);
+	perdidos += f - c;
+	for(; c != f; c++)
+		anotar(cola[c & (CAPACIDAD - 1)]);
+	cabeza.store(c, std::memory_order_release);
+}
+
+void EscritorMidi::anotar(const Mensaje& m)
+{
+	if(m.estado == MIDI_NOTE_ON)
+		velocidadSonando[m.dato1 & 127] = m.dato2;   // velocidad 0 también es soltar
+	else if(m.estado == MIDI_NOTE_OFF)
+		velocidadSonando[m.dato1 & 127] = 0;
+}
+
+/*
+--------------------------------------------------------------
+ reconciliar()
+ Al abrir el puerto: el dispositivo pudo quedar con notas de antes
+ (se desenchufó con notas apretadas) y no recibió lo que se descartó
+ mientras no estaba. Se apagan las 128 notas, como allNotesOff, y se
+ vuelven a tocar las que según los mensajes siguen sonando.
+--------------------------------------------------------------
+*/
+
+void EscritorMidi::reconciliar()
+{
+	for(int n = 0; n < 128; n++)
+		midiOut.sendNoteOff(canal, n, 0);
+	for(int n = 0; n < 128; n++)
+		if(velocidadSonando[n] > 0)
+			midiOut.sendNoteOn(canal, n, velocidadSonando[n]);
+}
+
+void EscritorMidi::escribirCola()
+{
+	uint32_t c = cabeza.load(std::memory_order_relaxed);
+	uint32_t f = fin.load(std::memory_order_acquire);
+	
+	for(; c != f; c++) {
+		const Mensaje& m = cola[c & (CAPACIDAD - 1)];
+		anotar(m);
+		switch(m.estado) {
+			case MIDI_NOTE_ON:        midiOut.sendNoteOn(canal, m.dato1, m.dato2); break;
+			case MIDI_NOTE_OFF:       midiOut.sendNoteOff(canal, m.dato1, m.dato2); break;
+			case MIDI_CONTROL_CHANGE: midiOut.sendControlChange(canal, m.dato1, m.dato2); break;
+			default: break;
+		}
+	}
+	cabeza.store(c, std::memory_order_release);
+}
+
+void EscritorMidi::cerrar()
+{
+	if(isThreadRunning()) {
+		{
+			// bajo el mutex, para que el hilo no se duerma justo después del aviso
+			std::lock_guard<std::mutex> lock(mutexAviso);
+			stopThread();
+		}
+		aviso.notify_all();
+		waitForThread(false);
+	}
+	if(conectado)
+		midiOut.closePort();
+	conectado = false;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxMidi.h"
+#include "descubridorDispositivos.h"
+
+/*
+--------------------------------------------------------------
+ escritorMidi.h
+
+ Clase EscritorMidi
+
+ Un puerto de salida MIDI con su propio hilo de escritura.
+ Escribir en un puerto MIDI puede bloquear (el driver, el cable,
+ una interfaz USB lenta); con un hilo por puerto una interfaz
+ saturada no frena a la simulación ni a los otros puertos.
+
+   - encolar() deja el mensaje en una cola circular sin bloqueo.
+   - despachar() despierta al hilo, una vez por tick.
+   - El hilo vacía la cola y escribe en el puerto.
+
+ La cola es de un productor y un consumidor: los mensajes los produce
+ el tick de simulación, o el hilo del GUI mientras la simulación está
+ detenida (ofApp sincroniza antes de tocar el MIDI desde el teclado).
+ Si la cola se llena, el mensaje se pierde y se cuenta.
+
+ El puerto se abre en el hilo de escritura, no en abrir(), cuando el
+ DescubridorDispositivos dice que existe. Mientras no existe (todavía
+ no se buscó, no está enchufado o se desenchufó) los mensajes se
+ descartan: el escritor funciona como un sumidero nulo y nadie espera.
+ Si el puerto vuelve a aparecer, se abre de nuevo.
+
+ Aunque no salgan, de los mensajes descartados se anota qué notas
+ quedaron sonando. Cada vez que el puerto se abre, el escritor apaga
+ las 128 notas y vuelve a tocar esas: lo que se mandó sin puerto
+ (por ejemplo al retomar un punto de control, antes de que aparezca
+ el dispositivo) llega igual al sinte externo, sin notas colgadas.
+--------------------------------------------------------------
+*/
+
+class EscritorMidi : public ofThread
+{
+public:
+	// Arranca el hilo de escritura; el puerto se abre cuando aparezca.
+	// Sin descubridor, el hilo intenta abrirlo directamente una vez.
+	void abrir(int puerto, int canal, DescubridorDispositivos* descubridor = nullptr);
+	
+	// Agrega un mensaje de canal a la cola (no bloquea)
+	void encolar(MidiStatus estado, int dato1, int dato2);
+	
+	// Despierta al hilo para que escriba lo encolado
+	void despachar();
+	
+	// Escribe lo que queda en la cola, detiene el hilo y cierra el puerto
+	void cerrar();
+	
+	int getPuerto()        { return puerto; }
+	int getCanal()         { return canal; }
+	uint64_t getPerdidos() { return perdidos.load(); }       // cola llena o sin puerto
+	bool estaConectado()   { return conectado.load(); }
+	
+private:
+	struct Mensaje {
+		MidiStatus estado;
+		uint8_t dato1;
+		uint8_t dato2;
+	};
+	
+	void threadedFunction();
+	void escribirCola();
+	void descartarCola();
+	void revisarPuerto();
+	void anotar(const Mensaje& m);   // sigue las notas que deberían estar sonando
+	void reconciliar();              // recién abierto: apaga todo y toca las que suenan
+	
+	static const uint32_t CAPACIDAD = 1024;  // potencia de 2
+	Mensaje cola[CAPACIDAD];
+	std::atomic<uint32_t> cabeza{0};   // próximo a leer (hilo de escritura)
+	std::atomic<uint32_t> fin{0};      // próximo a escribir (productor)
+	
+	std::mutex mutexAviso;
+	std::condition_variable aviso;
+	bool hayAviso = false;
+	
+	ofxMidiOut midiOut;
+	DescubridorDispositivos* descubridor = nullptr;
+	uint32_t versionVista = 0;       // versión de la lista de puertos ya revisada
+	string nombreAbierto;
+	std::atomic<bool> conectado{false};
+	uint8_t velocidadSonando[128] = {0}; // por nota, 0 = apagada (hilo de escritura)
+	int puerto = 0;
+	int canal = 1;
+	std::atomic<uint64_t> perdidos{0};
+};
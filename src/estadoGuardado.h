@@ -0,0 +1,56 @@
+#pragma once
+#include "ofMain.h"
+#include "parametros.h"
+
+/*
+--------------------------------------------------------------
+ estadoGuardado.h
+
+ Formato fijo del estado de la simulación en un punto de control
+ (ver PuntoControl). Son estructuras planas, con tipos de tamaño fijo
+ y sin punteros, que se copian tal cual al archivo mapeado en memoria.
+
+ Si se cambia cualquiera de estas estructuras hay que subir
+ VERSION_PUNTO_CONTROL: los archivos viejos se ignoran.
+--------------------------------------------------------------
+*/
+
+static const uint32_t VERSION_PUNTO_CONTROL = 1;
+static const int MAX_PARAMETROS_GUARDADOS = 32;
+
+// Una pelota
+struct EstadoPelota {
+	float pos[2];
+	float vel[2];
+	float posAnterior[2];
+	float radio;
+	float tiempoVital;
+	float tiempoDefuncion;     // segundos del reloj de la simulación
+	float dulceEspera;
+	int32_t nota;
+	int32_t salida;
+	int32_t ccOpenTime;        // milisegundos del reloj de la simulación
+	uint32_t azar[4];          // estado del generador propio
+	uint8_t esperandoNacer;
+	uint8_t noteOn;            // la nota estaba sonando
+	uint8_t relleno[2];
+};
+
+// Lo demás: parámetros, generación y estado de ofApp
+struct EstadoSimulacion {
+	double segundos;           // hora del reloj cuando se guardó
+	double tiempoDefuncion;
+	uint64_t numeroGeneracion;
+	uint64_t semillaSesion;
+	uint64_t tick;
+	int32_t cantidadPelotas;   // pelotas vivas guardadas a continuación
+	int32_t numPelotas;        // NUM_PELOTAS de la generación
+	uint8_t laNada;
+	uint8_t relleno[3];
+	uint32_t numParametros;
+	float parametros[MAX_PARAMETROS_GUARDADOS];
+};
+
+static_assert(sizeof(EstadoPelota) == 72, "EstadoPelota cambió de tamaño: subir VERSION_PUNTO_CONTROL");
+static_assert(sizeof(EstadoSimulacion) == 184, "EstadoSimulacion cambió de tamaño: subir VERSION_PUNTO_CONTROL");
+static_assert(NUM_PARAMETROS <= MAX_PARAMETROS_GUARDADOS, "no entran todos los parámetros en EstadoSimulacion");
@@ -0,0 +1,138 @@
+/*
+--------------------------------------------------------------
+ estelas.cpp
+
+ Implementación de la clase Estelas
+--------------------------------------------------------------
+*/
+
+#include "estelas.h"
+#include "azar.h"
+#include <chrono>
+
+void Estelas::setup(int capacidad)
+{
+	puntos.assign(capacidad * LARGO_MAX, ofVec2f());
+	cabeza.assign(capacidad, 0);
+	llenos.assign(capacidad, 0);
+	generaciones.assign(capacidad, UINT32_MAX);   // ningún anillo es de nadie todavía
+}
+
+//--------------------------------------------------------------
+// setLargo(delay, feedback, fraccion)
+// El delay da el largo (0..LARGO_MAX) y el feedback lo estira
+// del 30 % (sin feedback) al total (feedback al máximo).
+//--------------------------------------------------------------
+
+void Estelas::setLargo(float delay, float feedback, float fraccion)
+{
+	float t = ofClamp(delay / 100.0f, 0, 1) * ofMap(feedback, 0, 150, 0.3f, 1.0f, true) * fraccion;
+	largo = (int)roundf(t * LARGO_MAX);
+}
+
+void Estelas::registrar(int lugar, uint32_t generacion, ofVec2f pos)
+{
+	if(generaciones[lugar] != generacion) {
+		generaciones[lugar] = generacion;   // otra pelota en este lugar: estela nueva
+		cabeza[lugar] = 0;
+		llenos[lugar] = 0;
+	}
+	puntos[lugar * LARGO_MAX + cabeza[lugar]] = pos;
+	cabeza[lugar] = (cabeza[lugar] + 1) % LARGO_MAX;
+	if(llenos[lugar] < LARGO_MAX) llenos[lugar]++;
+}
+
+/*
+--------------------------------------------------------------
+ construir(lugar, radio, color, tira, cantidad)
+ De la posición más nueva a la más vieja, dos vértices por
+ posición, a los costados del recorrido. El ancho va de medio
+ radio a cero y la transparencia de la mitad del color a cero.
+ Si la tira ya tiene otra estela, se repiten su último vértice y
+ el primero de esta: los triángulos del medio no tienen área.
+--------------------------------------------------------------
+*/
+
+void Estelas::construir(int lugar, float radio, const ofColor& color,
+						vector<VerticeEstela>& tira, int& cantidad)
+{
+	int n = min(largo, (int)llenos[lugar]);
+	if(n < 2) return;
+
+	const ofVec2f* anillo = &puntos[lugar * LARGO_MAX];
+	int ultimo = cabeza[lugar] + LARGO_MAX - 1;    // posición más nueva (módulo LARGO_MAX)
+	auto punto = [&](int j) -> const ofVec2f& { return anillo[(ultimo - j) % LARGO_MAX]; };
+
+	bool unir = cantidad > 0;
+	if(unir) {
+		tira[cantidad] = tira[cantidad - 1];
+		cantidad++;
+	}
+
+	for(int j = 0; j < n; j++) {
+		const ofVec2f& p = punto(j);
+		ofVec2f tangente = punto(max(j - 1, 0)) - punto(min(j + 1, n - 1));
+		float largoTangente = tangente.length();
+		ofVec2f normal = (largoTangente > 1e-4f) ? ofVec2f(-tangente.y, tangente.x) / largoTangente : ofVec2f(0, 0);
+
+		float f = 1.0f - (float)j / (n - 1);
+		float ancho = radio * 0.5f * f;
+		ofColor c = color;
+		c.a = color.a * 0.5f * f;
+
+		VerticeEstela a = { p.x + normal.x * ancho, p.y + normal.y * ancho, c };
+		VerticeEstela b = { p.x - normal.x * ancho, p.y - normal.y * ancho, c };
+		if(j == 0 && unir)
+			tira[cantidad++] = a;
+		tira[cantidad++] = a;
+		tira[cantidad++] = b;
+	}
+}
+
+/*
+--------------------------------------------------------------
+ benchmark()
+ 2000 pelotas que se mueven al azar durante 600 ticks, con la
+ estela al máximo. Muestra el tiempo por tick de registrar y
+ construir, los vértices por tick y la memoria reservada.
+--------------------------------------------------------------
+*/
+
+void Estelas::benchmark()
+{
+	const int numPelotas = 2000;
+	const int ticks = 600;
+
+	Estelas estelas;
+	estelas.setup(numPelotas);
+	estelas.setLargo(100, 150);
+
+	vector<VerticeEstela> tira(numPelotas * verticesPorPelota());
+	vector<ofVec2f> pos(numPelotas), vel(numPelotas);
+	Azar azar(1);
+	for(int i = 0; i < numPelotas; i++) {
+		pos[i].set(azar.uniforme(0, 1024), azar.uniforme(0, 768));
+		vel[i].set(azar.uniforme(-15, 15), azar.uniforme(-15, 15));
+	}
+
+	double total = 0;
+	int vertices = 0;
+	for(int t = 0; t < ticks; t++) {
+		for(int i = 0; i < numPelotas; i++)
+			pos[i] += vel[i];
+
+		auto inicio = std::chrono::steady_clock::now();
+		int cantidad = 0;
+		for(int i = 0; i < numPelotas; i++) {
+			estelas.registrar(i, 0, pos[i]);
+			estelas.construir(i, 20, ofColor(255, 120, 0), tira, cantidad);
+		}
+		total += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count();
+		vertices = cantidad;
+	}
+
+	ofLogNotice("Estelas") << numPelotas << " pelotas, largo " << estelas.getLargo() << ": "
+						   << ofToString(total / ticks, 1) << " us por tick, "
+						   << vertices << " vértices, historia " << estelas.getMemoria() / 1024 << " KB, tira "
+						   << tira.size() * sizeof(VerticeEstela) / 1024 << " KB";
+}
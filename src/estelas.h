@@ -0,0 +1,72 @@
+#pragma once
+#include "ofMain.h"
+#include "instantanea.h"
+
+/*
+--------------------------------------------------------------
+ estelas.h
+
+ Clase Estelas
+
+ Cada pelota deja una estela que se afina y se apaga hacia atrás.
+ El largo sigue a los sliders de delay y feedback: con más delay
+ la estela es más larga, y el feedback la estira (como el eco).
+
+ Historia de posiciones:
+   - Un anillo de LARGO_MAX posiciones por lugar del pool, todos
+     en un mismo arreglo contiguo (lugar * LARGO_MAX + i). El
+     lugar de una pelota no cambia mientras vive; cuando el lugar
+     pasa a otra pelota (otra generación del lugar) el anillo se
+     vacía.
+   - La memoria se reserva en setup() y no crece: capacidad del
+     pool x LARGO_MAX posiciones.
+
+ Dibujo:
+   - construir() arma, en la CPU y en el hilo de la simulación,
+     la estela de una pelota como tramos de una sola tira de
+     triángulos, unidos con triángulos degenerados. draw() la
+     dibuja en un solo ofMesh, sin importar cuántas pelotas haya.
+   - Cada pelota usa a lo sumo verticesPorPelota() vértices: el
+     costo por frame es proporcional a pelotas x largo.
+
+ benchmark() arma las estelas de muchas pelotas sin ventana
+ (--bench-estelas), para medir el camino de CPU.
+--------------------------------------------------------------
+*/
+
+class Estelas
+{
+public:
+	static const int LARGO_MAX = 32;   // posiciones guardadas por pelota
+
+	// Vértices de la tira que puede usar una pelota (con la unión)
+	static int verticesPorPelota() { return LARGO_MAX * 2 + 2; }
+
+	// Reserva la historia para "capacidad" lugares del pool
+	void setup(int capacidad);
+
+	// Largo de las estelas según delay (0..100) y feedback (0..150).
+	// "fraccion" lo acorta cuando baja la calidad (ControlCalidad).
+	void setLargo(float delay, float feedback, float fraccion = 1.0f);
+	int getLargo() { return largo; }
+
+	// Anota la posición del tick de la pelota del lugar "lugar"
+	void registrar(int lugar, uint32_t generacion, ofVec2f pos);
+
+	// Agrega a la tira la estela de la pelota del lugar "lugar"
+	void construir(int lugar, float radio, const ofColor& color,
+				   vector<VerticeEstela>& tira, int& cantidad);
+
+	// Memoria reservada para la historia, en bytes
+	size_t getMemoria() { return puntos.size() * sizeof(ofVec2f) + generaciones.size() * (sizeof(uint32_t) + 2); }
+
+	// Mide construir() con muchas pelotas y muestra el tiempo por tick
+	static void benchmark();
+
+private:
+	vector<ofVec2f> puntos;           // capacidad x LARGO_MAX
+	vector<uint8_t> cabeza;           // próxima posición a escribir de cada anillo
+	vector<uint8_t> llenos;           // posiciones válidas de cada anillo
+	vector<uint32_t> generaciones;    // de qué pelota es cada anillo
+	int largo = 0;
+};
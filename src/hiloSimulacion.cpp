@@ -0,0 +1,75 @@
+/*
+--------------------------------------------------------------
+ hiloSimulacion.cpp
+
+ Implementación de la clase HiloSimulacion
+ 
+ El mutex solo se usa en los dos puntos de encuentro por frame
+ (lanzar / esperar). Los datos del dibujo no pasan por acá:
+ viajan por un TripleBuffer sin bloqueo.
+--------------------------------------------------------------
+*/
+
+#include "hiloSimulacion.h"
+
+void HiloSimulacion::setup(std::function<void()> funcionPaso)
+{
+	paso = funcionPaso;
+	startThread();
+}
+
+void HiloSimulacion::lanzar()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutexPaso);
+		pedido = true;
+	}
+	condicion.notify_all();
+}
+
+void HiloSimulacion::esperar()
+{
+	std::unique_lock<std::mutex> lock(mutexPaso);
+	condicion.wait(lock, [this]{ return !pedido; });
+}
+
+/*
+--------------------------------------------------------------
+ threadedFunction()
+ Duerme hasta que haya un paso pedido, lo ejecuta y avisa
+ a quien esté esperando.
+--------------------------------------------------------------
+*/
+
+void HiloSimulacion::threadedFunction()
+{
+	while(isThreadRunning()) {
+		{
+			std::unique_lock<std::mutex> lock(mutexPaso);
+			condicion.wait(lock, [this]{ return pedido || !isThreadRunning(); });
+			if(!pedido) break;
+		}
+		
+		uint64_t inicio = ofGetElapsedTimeMicros();
+		paso();
+		milisPaso = (ofGetElapsedTimeMicros() - inicio) / 1000.0f;
+		
+		{
+			std::lock_guard<std::mutex> lock(mutexPaso);
+			pedido = false;
+		}
+		condicion.notify_all();
+	}
+}
+
+void HiloSimulacion::exit()
+{
+	esperar();
+	{
+		// bajo el mutex, para que el hilo no se duerma justo después del aviso
+		std::lock_guard<std::mutex> lock(mutexPaso);
+		stopThread();
+	}
+	condicion.notify_all();
+	waitForThread(false);
+}
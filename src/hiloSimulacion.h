@@ -0,0 +1,47 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ hiloSimulacion.h
+
+ Clase HiloSimulacion
+
+ Corre un paso de simulación en un hilo aparte, de a un paso por vez:
+
+   - lanzar() pide un paso y vuelve enseguida.
+   - esperar() bloquea hasta que el paso pedido haya terminado.
+
+ ofApp llama a esperar() y lanzar() al comienzo de update(), así el
+ tick N+1 se simula mientras draw() dibuja el tick N. El frame pasa a
+ costar el máximo entre simular y dibujar, en lugar de la suma.
+--------------------------------------------------------------
+*/
+
+class HiloSimulacion : public ofThread
+{
+public:
+	// Función que se ejecuta en cada paso
+	void setup(std::function<void()> funcionPaso);
+	
+	// Pide un paso (no bloquea)
+	void lanzar();
+	
+	// Espera a que termine el paso pedido
+	void esperar();
+	
+	// Termina el paso en curso y detiene el hilo
+	void exit();
+	
+	// Duración del último paso en milisegundos
+	float getMilisPaso() { return milisPaso.load(); }
+	
+private:
+	void threadedFunction();
+	
+	std::function<void()> paso;
+	std::mutex mutexPaso;
+	std::condition_variable condicion;
+	bool pedido = false;       // hay un paso pedido o en curso
+	std::atomic<float> milisPaso{0};
+};
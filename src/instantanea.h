@@ -0,0 +1,48 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ instantanea.h
+
+ Lo que draw() necesita saber de la simulación en un tick:
+ un arreglo compacto con posición, radio y color (con la
+ transparencia ya calculada) de cada pelota visible.
+
+ También lleva los destellos de los rebotes y choques recientes
+ (ver Destellos), ya con su tamaño y transparencia del tick, y las
+ estelas de todas las pelotas armadas como una sola tira de
+ triángulos (ver Estelas).
+
+ La simulación llena una Instantanea al final de cada tick y la
+ publica en un TripleBuffer; draw() dibuja la última publicada
+ sin tocar las pelotas.
+--------------------------------------------------------------
+*/
+
+struct PelotaVisual {
+	float x, y;
+	float radio;
+	ofColor color;     // color de la nota, alfa = tiempo de vida
+};
+
+struct DestelloVisual {
+	float x, y;
+	float radio;
+	ofColor color;
+};
+
+struct VerticeEstela {
+	float x, y;
+	ofColor color;
+};
+
+struct Instantanea {
+	vector<PelotaVisual> pelotas;  // se dimensiona una vez a la capacidad del pool
+	int cantidad = 0;              // pelotas válidas en este tick
+	vector<DestelloVisual> destellos; // se dimensiona una vez a Destellos::MAX_DESTELLOS
+	int cantidadDestellos = 0;
+	vector<VerticeEstela> estela;  // tira de triángulos, dimensionada con Estelas::verticesPorPelota()
+	int cantidadEstela = 0;
+	uint64_t tick = 0;             // número de tick simulado
+};
@@ -15,9 +15,147 @@
 // main()
 //  Configura los parámetros iniciales de la ventana
 //  y ejecuta la aplicación mediante ofRunApp().
+//
+//  Opciones de línea de comandos:
+//   --reloj-virtual[=N]  simula con tiempo virtual, N veces más
+//                        rápido que el tiempo real (por defecto 4)
+//   --semilla=N          semilla de sesión: repite exactamente una función
+//   --midi-salidas=A,B,..  puertos MIDI entre los que se reparten las notas
+//   --midi-efectos=P     puerto MIDI aparte para los CC de efectos y grabación
+//   --midi-ruteo=R       reparto de las pelotas: grado, radio o alternado
+//   --sinte              las notas suenan también en el sintetizador interno
+//   --render-wav=ARCHIVO renderiza 10 s de prueba del sintetizador a un WAV
+//                        (con la semilla de sesión) y sale, sin abrir ventana
+//   --test-voces         llena todas las voces del sintetizador con notas sostenidas,
+//                        pide una más y sale (con 1 si no roba bien una voz)
+//   --bench-dsp          mide la cadena de efectos en bloques de 64/128/256 y sale
+//   --bench-estelas      mide el armado de las estelas de 2000 pelotas (sin ventana) y sale
+//   --punto-control=N    guarda el estado cada N segundos (0 = nunca, por defecto 2)
+//   --sin-retomar        arranca de cero aunque haya un punto de control guardado
+//   --test-alloc[=N]     corre una escena estable con reloj virtual y falla (sale con 1)
+//                        si alguno de los N frames (por defecto 1800) después del
+//                        calentamiento pide memoria. Requiere compilar con TF_CONTAR_MEMORIA
+//   --obstaculos=ARCHIVO obstáculos a cargar (y donde se guarda lo dibujado),
+//                        en data/ (por defecto obstaculos.txt)
+//   --reloj-midi=PUERTO  sigue el reloj MIDI de esa entrada (número o nombre)
+//   --shard=i/n          este proceso es la franja i (de 1 a n, de izquierda a derecha)
+//                        de una arena repartida entre n procesos (ver README)
+//   --shard-puerto=P     puerto base del pase de pelotas (por defecto 9100)
+//   --test-shard         pasa pelotas entre dos franjas por localhost (en los puertos
+//                        P y P+1) y sale (con 1 si alguna se perdió), sin abrir ventana
+//   --capacidad=N        máximo de pelotas vivas a la vez, de 1 a 65536 (por defecto 512)
+//   --pool=POLITICA      con el pool lleno: rechazar (la nueva no nace, por defecto)
+//                        o reemplazar (muere la más vieja)
+//   --presupuesto-frame=MS  tiempo de update + draw a sostener bajando la calidad
+//                        visual (por defecto 16.6)
+//   --test-reloj-midi    pasa un reloj MIDI sintético con jitter por el filtro de tempo
+//                        y sale (con 1 si no lo sigue), sin abrir ventana
 //--------------------------------------------------------------
 
-int main( ){
+int main(int argc, char* argv[]){
+	
+	auto app = std::make_shared<ofApp>();
+	app->arranque.iniciar();
+	string rutaWav;
+	bool pruebaParticion = false;
+	
+	for (int i = 1; i < argc; i++) {
+		string opcion = argv[i];
+		if (opcion.compare(0, 15, "--reloj-virtual") == 0) {
+			app->usarRelojVirtual = true;
+			if (opcion.size() > 16 && opcion[15] == '=')
+				app->velocidadVirtual = ofToFloat(opcion.substr(16));
+		}
+		if (opcion.compare(0, 10, "--semilla=") == 0)
+			app->semillaSesion = std::stoull(opcion.substr(10));
+		if (opcion.compare(0, 15, "--midi-salidas=") == 0)
+			for (auto& puerto : ofSplitString(opcion.substr(15), ",", true, true))
+				app->puertosMidi.push_back(ofToInt(puerto));
+		if (opcion.compare(0, 15, "--midi-efectos=") == 0)
+			app->puertoEfectosMidi = ofToInt(opcion.substr(15));
+		if (opcion.compare(0, 16, "--punto-control=") == 0)
+			app->intervaloPuntoControl = ofToFloat(opcion.substr(16));
+		if (opcion == "--sin-retomar")
+			app->retomar = false;
+		if (opcion.compare(0, 12, "--test-alloc") == 0) {
+			if (!ContadorMemoria::activo()) {
+				ofLogError("test-alloc") << "hay que compilar con TF_CONTAR_MEMORIA (PROJECT_DEFINES)";
+				return 1;
+			}
+			app->framesPruebaMemoria = (opcion.size() > 13 && opcion[12] == '=') ? ofToInt(opcion.substr(13)) : 1800;
+			app->usarRelojVirtual = true;
+			app->retomar = false;
+			app->intervaloPuntoControl = 0;
+		}
+		if (opcion.compare(0, 13, "--obstaculos=") == 0)
+			app->archivoObstaculos = opcion.substr(13);
+		if (opcion.compare(0, 13, "--reloj-midi=") == 0)
+			app->entradaRelojMidi = opcion.substr(13);
+		if (opcion.compare(0, 8, "--shard=") == 0) {
+			vector<string> partes = ofSplitString(opcion.substr(8), "/");
+			if (partes.size() != 2 || ofToInt(partes[0]) < 1 || ofToInt(partes[0]) > ofToInt(partes[1])) {
+				ofLogError("shard") << "se espera --shard=i/n, con i entre 1 y n";
+				return 1;
+			}
+			app->indiceParticion = ofToInt(partes[0]) - 1;
+			app->totalParticiones = ofToInt(partes[1]);
+		}
+		if (opcion.compare(0, 15, "--shard-puerto=") == 0)
+			app->puertoParticion = ofToInt(opcion.substr(15));
+		if (opcion == "--test-shard")
+			pruebaParticion = true;
+		if (opcion.compare(0, 12, "--capacidad=") == 0) {
+			app->capacidadPelotas = ofToInt(opcion.substr(12));
+			if (app->capacidadPelotas < 1 || app->capacidadPelotas > 65536) {
+				ofLogError("capacidad") << "se espera --capacidad=N, con N entre 1 y 65536";
+				return 1;
+			}
+		}
+		if (opcion.compare(0, 7, "--pool=") == 0) {
+			string politica = opcion.substr(7);
+			if (politica == "rechazar")        app->politicaPool = POOL_RECHAZAR_NUEVAS;
+			else if (politica == "reemplazar") app->politicaPool = POOL_REEMPLAZAR_VIEJAS;
+			else {
+				ofLogError("pool") << "se espera --pool=rechazar o --pool=reemplazar";
+				return 1;
+			}
+		}
+		if (opcion.compare(0, 20, "--presupuesto-frame=") == 0) {
+			app->presupuestoFrame = ofToFloat(opcion.substr(20));
+			if (!(app->presupuestoFrame > 0) || !std::isfinite(app->presupuestoFrame)) {
+				ofLogError("presupuesto-frame") << "se espera --presupuesto-frame=MS, con MS mayor que 0";
+				return 1;
+			}
+		}
+		if (opcion == "--test-reloj-midi")
+			return RelojMidi::prueba() ? 0 : 1;
+		if (opcion == "--sinte")
+			app->sintetizadorInterno = true;
+		if (opcion == "--test-voces")
+			return Sintetizador::pruebaVoces() ? 0 : 1;
+		if (opcion == "--bench-dsp") {
+			CadenaEfectos::benchmark();
+			return 0;
+		}
+		if (opcion == "--bench-estelas") {
+			Estelas::benchmark();
+			return 0;
+		}
+		if (opcion.compare(0, 13, "--render-wav=") == 0)
+			rutaWav = opcion.substr(13);
+		if (opcion.compare(0, 13, "--midi-ruteo=") == 0) {
+			string regla = opcion.substr(13);
+			if (regla == "grado")      app->ruteoMidi = RUTEO_GRADO;
+			else if (regla == "radio") app->ruteoMidi = RUTEO_RADIO;
+			else                       app->ruteoMidi = RUTEO_ALTERNADO;
+		}
+	}
+
+	if (pruebaParticion)
+		return Particion::prueba(app->puertoParticion) ? 0 : 1;
+	
+	if (!rutaWav.empty())
+		return Sintetizador::renderizarWav(rutaWav, 10, app->semillaSesion) ? 0 : 1;
 
 	ofGLWindowSettings settings;
 	// tamaño inicial de la ventana
@@ -30,7 +168,7 @@ int main( ){
 	auto window = ofCreateWindow(settings);
 	
 	// ejecuta la aplicación
-	ofRunApp(window, std::make_shared<ofApp>());
+	ofRunApp(window, app);
 	ofRunMainLoop();
 
 }
@@ -10,36 +10,294 @@
 --------------------------------------------------------------
 */
 
-void MidiSender::setup(int port, int midiCh) {
+// CC que abren un envío en Ableton al rebotar en las paredes
+static bool esEnvio(int controlador) {
+	return controlador == 7 || controlador == 9;
+}
+
+void MidiSender::setup(int port, int midiCh, DescubridorDispositivos* d) {
 	
-	midiOut.listOutPorts();  // Imprime en consola los puertos disponibles
+	descubridor = d;         // lista los puertos en su hilo (antes: listOutPorts() acá)
 	
-	midiOut.openPort(port);  // Abre o conecta el puerto dado
-	channel = midiCh;        // Fija el canal MIDI activo
+	for (int i = 0; i < 128; ++i)
+		ultimoValorCC[i] = -1;
+	
+	numSalidas = 0;
+	salidaEfectos = 0;
+	agregarSalida(port, midiCh);   // Abre o conecta el puerto dado, en el canal dado
+}
+
+// Agrega otra salida con su hilo de escritura (el puerto se abre en ese hilo)
+int MidiSender::agregarSalida(int port, int midiCh) {
+	if (numSalidas >= MAX_SALIDAS) {
+		ofLogWarning("MidiSender") << "No hay lugar para otra salida MIDI (máximo " << MAX_SALIDAS << ")";
+		return -1;
+	}
+	salidas[numSalidas].escritor.abrir(port, midiCh, descubridor);
+	return numSalidas++;
+}
+
+void MidiSender::setSalidaEfectos(int salida) {
+	if (salida >= 0 && salida < numSalidas)
+		salidaEfectos = salida;
+}
+
+/*
+--------------------------------------------------------------
+ elegirSalida(grado, radio)
+ Se llama una vez, cuando nace la pelota. Con más de una salida,
+ la de efectos queda solo para los CC y las notas se reparten
+ entre las demás.
+--------------------------------------------------------------
+*/
+
+int MidiSender::elegirSalida(int grado, float radio) {
+	if (numSalidas <= 1) return 0;
+	
+	int n = numSalidas - 1;    // salidas de notas
+	int k;
+	switch (ruteo) {
+		case RUTEO_GRADO:  k = grado % n; break;
+		case RUTEO_RADIO:  k = min((int)ofMap(radio, 10.0f, 50.0f, 0, n, true), n - 1); break;
+		default:           k = proximaAlternada++ % n; break;
+	}
+	return k < salidaEfectos ? k : k + 1;  // salteo la de efectos
+}
+
+// Configura el presupuesto de cada tick
+void MidiSender::setPresupuesto(int bytes, int maxNotas, int maxEspera) {
+	bytesPorTick = bytes;
+	maxNotasPorTick = maxNotas;
+	maxTicksEspera = maxEspera;
 }
 
 // Función para mandar notas. El rango es de 0 a 127 pero voy a usar notas entre 24 y 96
-void MidiSender::sendNoteOn(int note, int velocity) {
-	midiOut.sendNoteOn(channel, note, velocity);
+// La nota queda pendiente hasta procesarTick(); si ya estaba pendiente se queda con la mayor intensidad.
+void MidiSender::sendNoteOn(int note, int velocity, int salida) {
+	if (sintetizador != nullptr) sintetizador->noteOn(note, velocity);
+	
+	Salida& s = salidas[salida < numSalidas ? salida : 0];
+	if (s.velocidadPendiente[note] > 0) {
+		s.velocidadPendiente[note] = max(s.velocidadPendiente[note], velocity);
+		s.fundidos++;
+		return;
+	}
+	s.velocidadPendiente[note] = velocity;
+	s.esperaPendiente[note] = 0;
+	s.soltarPendiente[note] = false;
+	s.notasPendientes++;
 }
 
 // Note off, velocity 0 equivale a no tocar
-void MidiSender::sendNoteOff(int note) {
-	midiOut.sendNoteOff(channel, note, 0);
+// Si el NoteOn de esa nota todavía no salió, el NoteOff lo sigue en el tick siguiente a su salida.
+void MidiSender::sendNoteOff(int note, int salida) {
+	if (sintetizador != nullptr) sintetizador->noteOff(note);
+	
+	Salida& s = salidas[salida < numSalidas ? salida : 0];
+	if (s.velocidadPendiente[note] > 0) {
+		s.soltarPendiente[note] = true;
+		return;
+	}
+	enviarNoteOff(s, note);
 }
 
 // Mensaje CC - numero de CC y valor mandando
 void MidiSender::sendControlChange(int controlador, int valor){
-	midiOut.sendControlChange(channel, controlador, valor);
+	if (esEnvio(controlador) && valor == 127) {
+		if (envioPendiente[controlador]) colapsados++;
+		envioPendiente[controlador] = true;
+		return;
+	}
+	enviarControlChange(controlador, valor);
+}
+
+// Mensaje CC que se repite en cada frame: si no cambió, no gasto el cable
+void MidiSender::sendControlChangeSiCambia(int controlador, int valor){
+	if (ultimoValorCC[controlador] == valor) return;
+	enviarControlChange(controlador, valor);
 }
 
-// Apagar las notas del canal
+// Apagar las notas de todas las salidas, y olvidar las que estaban por salir
 void MidiSender::allNotesOff() {
-	for (int n = 0; n < 128; ++n)
-		sendNoteOff(n);
+	if (sintetizador != nullptr) sintetizador->todasOff();
+	
+	for (int i = 0; i < numSalidas; ++i) {
+		Salida& s = salidas[i];
+		for (int n = 0; n < 128; ++n) {
+			s.velocidadPendiente[n] = 0;
+			s.soltarPendiente[n] = false;
+			s.soltarProximoTick[n] = false;
+		}
+		s.notasPendientes = 0;
+		
+		for (int n = 0; n < 128; ++n)
+			enviarNoteOff(s, n);
+		s.escritor.despachar();
+	}
 }
 
-// Cerrar puerto MIDI
+// Cerrar los puertos MIDI (cada escritor vacía su cola antes de cerrar)
 void MidiSender::exit() {
-	midiOut.closePort(); 
+	for (int i = 0; i < numSalidas; ++i)
+		salidas[i].escritor.cerrar();
+	numSalidas = 0;
+}
+
+//--------------------------------------------------------------
+// procesar()
+// Lo que publicaron las pelotas en el tick, en el mismo orden.
+// La pared izquierda abre el envío cc9 y la derecha el cc7 (ableton).
+// Notas y cc fuera de 0..127 se ignoran: indexan tablas de 128.
+//--------------------------------------------------------------
+
+void MidiSender::procesar(const EventoSimulacion* eventos, int cantidad, uint64_t tick) {
+	for (int i = 0; i < cantidad; i++) {
+		const EventoSimulacion& e = eventos[i];
+		switch (e.tipo) {
+			case SIM_NOTA_ON:
+				if (e.nota >= 0 && e.nota <= 127)
+					sendNoteOn(e.nota, 100, e.salida);
+				break;
+				
+			case SIM_NOTA_OFF:
+				if (e.nota >= 0 && e.nota <= 127)
+					sendNoteOff(e.nota, e.salida);
+				break;
+				
+			case SIM_PARED:
+				if (e.pared == PARED_IZQUIERDA)
+					sendControlChange(9, 127);
+				else if (e.pared == PARED_DERECHA)
+					sendControlChange(7, 127);
+				break;
+				
+			case SIM_OBSTACULO:
+				if (e.cc >= 0 && e.cc <= 127)
+					sendControlChange(e.cc, 127);
+				break;
+				
+			default:
+				break;
+		}
+	}
+}
+
+/*
+--------------------------------------------------------------
+ procesarTick()
+ 
+ Se llama una vez por frame, después de actualizar las pelotas.
+   1. Salen los NoteOff que quedaron atrás de un NoteOn diferido.
+   2. Sale un solo CC por cada envío pedido en el tick.
+   3. Salen los NoteOn pendientes por orden de prioridad (más espera,
+      más intensidad, más grave) mientras alcance el presupuesto.
+   4. Los que quedan esperan un tick más, o se descartan si esperaron demasiado.
+ Los mensajes que ya salieron directo en el tick (NoteOff, CC) también
+ cuentan para el presupuesto. Cada salida tiene su propio presupuesto,
+ y al final se despiertan los escritores.
+--------------------------------------------------------------
+*/
+
+void MidiSender::procesarTick() {
+	
+	for (int c = 0; c < 128; ++c) {
+		if (envioPendiente[c]) {
+			enviarControlChange(c, 127);
+			envioPendiente[c] = false;
+		}
+	}
+	
+	for (int i = 0; i < numSalidas; ++i) {
+		procesarNotas(salidas[i]);
+		salidas[i].escritor.despachar();
+	}
+}
+
+void MidiSender::procesarNotas(Salida& s) {
+	
+	for (int n = 0; n < 128; ++n) {
+		if (s.soltarProximoTick[n]) {
+			enviarNoteOff(s, n);
+			s.soltarProximoTick[n] = false;
+		}
+	}
+	
+	if (s.notasPendientes > 0) {
+		int cantidad = 0;
+		for (int n = 0; n < 128; ++n)
+			if (s.velocidadPendiente[n] > 0) s.orden[cantidad++] = n;
+		
+		std::sort(s.orden, s.orden + cantidad, [&s](int a, int b) {
+			if (s.esperaPendiente[a] != s.esperaPendiente[b]) return s.esperaPendiente[a] > s.esperaPendiente[b];
+			if (s.velocidadPendiente[a] != s.velocidadPendiente[b]) return s.velocidadPendiente[a] > s.velocidadPendiente[b];
+			return a < b;
+		});
+		
+		int enviadas = 0;
+		for (int k = 0; k < cantidad; ++k) {
+			int n = s.orden[k];
+			
+			if (enviadas < maxNotasPorTick && s.bytesEsteTick + 3 <= bytesPorTick) {
+				enviarNoteOn(s, n, s.velocidadPendiente[n]);
+				if (s.soltarPendiente[n]) s.soltarProximoTick[n] = true;
+				s.velocidadPendiente[n] = 0;
+				s.notasPendientes--;
+				enviadas++;
+			}
+			else if (++s.esperaPendiente[n] > maxTicksEspera) {
+				// una nota tan tarde ya no tiene que ver con su rebote
+				s.velocidadPendiente[n] = 0;
+				s.soltarPendiente[n] = false;
+				s.notasPendientes--;
+				s.descartados++;
+			}
+			else
+				s.diferidos++;
+		}
+	}
+	
+	s.bytesEsteTick = 0;
+}
+
+// Contadores sumados de todas las salidas
+uint64_t MidiSender::getDiferidos() {
+	uint64_t total = 0;
+	for (int i = 0; i < numSalidas; ++i) total += salidas[i].diferidos.load();
+	return total;
+}
+
+uint64_t MidiSender::getDescartados() {
+	uint64_t total = 0;
+	for (int i = 0; i < numSalidas; ++i) total += salidas[i].descartados.load();
+	return total;
+}
+
+uint64_t MidiSender::getFundidos() {
+	uint64_t total = 0;
+	for (int i = 0; i < numSalidas; ++i) total += salidas[i].fundidos;
+	return total;
+}
+
+uint64_t MidiSender::getPerdidos() {
+	uint64_t total = 0;
+	for (int i = 0; i < numSalidas; ++i) total += salidas[i].escritor.getPerdidos();
+	return total;
+}
+
+// Envíos directos a la cola del escritor. Cada mensaje de canal ocupa 3 bytes.
+void MidiSender::enviarNoteOn(Salida& s, int note, int velocity) {
+	s.escritor.encolar(MIDI_NOTE_ON, note, velocity);
+	s.bytesEsteTick += 3;
+}
+
+void MidiSender::enviarNoteOff(Salida& s, int note) {
+	s.escritor.encolar(MIDI_NOTE_OFF, note, 0);
+	s.bytesEsteTick += 3;
+}
+
+void MidiSender::enviarControlChange(int controlador, int valor) {
+	Salida& s = salidas[salidaEfectos];
+	s.escritor.encolar(MIDI_CONTROL_CHANGE, controlador, valor);
+	ultimoValorCC[controlador] = valor;
+	s.bytesEsteTick += 3;
 }
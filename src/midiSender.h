@@ -3,6 +3,9 @@
 
 #include "ofMain.h"
 #include "ofxMidi.h"
+#include "escritorMidi.h"
+#include "sintetizador.h"
+#include "busEventos.h"
 
 /*
 --------------------------------------------------------------
@@ -16,35 +19,160 @@
    - Envío de notas (NoteOn / NoteOff)
    - Envío de mensajes de Control Change o Continuos Controller (CC)
    - Apagado global de notas
+   - Presupuesto de ancho de banda por tick
 
  Permite abstraer la complejidad de ofxMidi y mantener el
  código limpio en otras clases.
+ 
+ Presupuesto por tick:
+ Un cable MIDI lleva unos 3 bytes por milisegundo, así que si muchas
+ pelotas rebotan en el mismo frame las notas se amontonan y se "corren".
+ Por eso los NoteOn no salen directamente: se juntan durante el tick y
+ salen todos juntos en procesarTick(), que se llama una vez por frame.
+   - Dos NoteOn de la misma nota en un tick se funden en uno.
+   - Salen como máximo maxNotasPorTick, y sin pasar bytesPorTick.
+   - Los que no entran quedan para los ticks siguientes, primero los
+     que más esperaron. Si esperan más de maxTicksEspera se descartan.
+   - Los CC 7 y 9 ("abrir envío" de las paredes) salen una sola vez
+     por tick, aunque los pidan muchas pelotas.
+   - Los CC que se mandan en cada frame (efectos) usan
+     sendControlChangeSiCambia() y salen solo si cambió su valor.
+
+ Varias salidas:
+ Con muchas pelotas un solo cable no alcanza. Se pueden abrir varias
+ salidas (puerto + canal), cada una con su hilo de escritura y su propio
+ presupuesto por tick (EscritorMidi). Las notas de cada pelota van a la
+ salida que le toca según la regla de ruteo, elegida al nacer:
+   - RUTEO_GRADO:     por grado de la escala (el mismo grado, la misma salida)
+   - RUTEO_RADIO:     por banda de radio (las grandes/graves juntas)
+   - RUTEO_ALTERNADO: una salida para cada pelota, por turno
+ Los CC (efectos, grabación y envíos) salen por la salida de efectos.
+ Si hay una sola salida, todo sale por ella, como antes.
+
+ Sintetizador interno:
+ Con setSintetizador() las notas también van directo al sintetizador
+ interno, en el momento del rebote, sin pasar por el presupuesto del cable.
+
+ Eventos de la simulación:
+ Está suscripto al BusEventos: procesar() traduce las notas y los
+ rebotes del tick a NoteOn/NoteOff y a los CC de envío de las paredes
+ y de los obstáculos.
 --------------------------------------------------------------
 */
 
-class MidiSender {
+enum ReglaRuteo {
+	RUTEO_GRADO,
+	RUTEO_RADIO,
+	RUTEO_ALTERNADO
+};
+
+class MidiSender : public OyenteEventos {
 public:
-	// Incializa el MIDI OUT (puerto y canal)
-	void setup(int port = 0, int channel = 1);
+	static const int MAX_SALIDAS = 8;
+	
+	// Incializa el MIDI OUT con una sola salida (puerto y canal).
+	// Los puertos se abren en segundo plano, cuando el descubridor los encuentra.
+	void setup(int port = 0, int channel = 1, DescubridorDispositivos* descubridor = nullptr);
+	
+	// Agrega otra salida. Devuelve su número, o -1 si no hay lugar.
+	int agregarSalida(int port, int channel = 1);
+	
+	// Salida por la que salen todos los CC
+	void setSalidaEfectos(int salida);
+	
+	// Las notas también suenan en el sintetizador interno (nullptr = no)
+	void setSintetizador(Sintetizador* s) { sintetizador = s; }
+	
+	// Regla para repartir las pelotas entre las salidas de notas
+	void setRuteo(ReglaRuteo regla) { ruteo = regla; }
+	
+	// Salida para una pelota nueva, según la regla de ruteo
+	int elegirSalida(int grado, float radio);
 	
 	// Envio nota (Note on) - mando número de nota e intensidad
-	void sendNoteOn(int note, int velocity);
+	void sendNoteOn(int note, int velocity, int salida = 0);
 	
 	// Apagar nota o soltar tecla (Note off)
-	void sendNoteOff(int note);
+	void sendNoteOff(int note, int salida = 0);
 	
 	// Envio mensaje de Control Change
 	void sendControlChange(int controlador, int valor);
 	
-	// Apago todas las notas MIDI
+	// Envio mensaje de Control Change solo si cambió desde el último envío
+	void sendControlChangeSiCambia(int controlador, int valor);
+	
+	// Apago todas las notas MIDI, en todas las salidas
 	void allNotesOff();
 	
-	// Cierra el puerto MIDI y lo libera para otra aplicación
+	// Cierra los puertos MIDI y los libera para otra aplicación
 	void exit();
 	
+	// Eventos del tick (notas y rebotes) a mensajes MIDI
+	void procesar(const EventoSimulacion* eventos, int cantidad, uint64_t tick) override;
+	
+	// Manda lo acumulado en el tick respetando el presupuesto (una vez por frame)
+	void procesarTick();
+	
+	// Configura el presupuesto por tick de cada salida
+	void setPresupuesto(int bytesPorTick, int maxNotasPorTick, int maxTicksEspera = 4);
+	
+	int getNumSalidas() { return numSalidas; }
+	
+	// Contadores de diagnóstico (suma de todas las salidas)
+	uint64_t getDiferidos();    // NoteOn que pasaron al tick siguiente
+	uint64_t getDescartados();  // NoteOn que esperaron demasiado
+	uint64_t getFundidos();     // NoteOn repetidos en un mismo tick
+	uint64_t getColapsados() { return colapsados; }  // CC de envío repetidos en un mismo tick
+	uint64_t getPerdidos();     // mensajes que no entraron en la cola de un escritor
+	
 
 private:
 	
-	ofxMidiOut midiOut;  // Salida MIDI
-	int channel;         // Canal MIDI (1 - 16)
+	// Estado de cada salida: su escritor y su presupuesto
+	struct Salida {
+		EscritorMidi escritor;
+		int bytesEsteTick = 0;               // bytes ya enviados en el tick actual
+		
+		// NoteOn pendientes, indexados por número de nota
+		int notasPendientes = 0;
+		int velocidadPendiente[128] = {0};   // 0 = no hay NoteOn pendiente
+		int esperaPendiente[128] = {0};      // ticks que lleva esperando
+		bool soltarPendiente[128] = {false}; // llegó el NoteOff antes de que saliera el NoteOn
+		bool soltarProximoTick[128] = {false};
+		int orden[128];                      // nota pendientes ordenadas por prioridad
+		
+		// los lee el hilo del GUI (info en pantalla)
+		std::atomic<uint64_t> diferidos{0};
+		std::atomic<uint64_t> descartados{0};
+		uint64_t fundidos = 0;
+	};
+	
+	void procesarNotas(Salida& s);
+	
+	// Envío directo a la cola del escritor, contando los bytes del tick
+	void enviarNoteOn(Salida& s, int note, int velocity);
+	void enviarNoteOff(Salida& s, int note);
+	void enviarControlChange(int controlador, int valor);
+	
+	DescubridorDispositivos* descubridor = nullptr;
+	Salida salidas[MAX_SALIDAS];
+	int numSalidas = 0;
+	int salidaEfectos = 0;
+	
+	Sintetizador* sintetizador = nullptr;
+	
+	// Ruteo
+	ReglaRuteo ruteo = RUTEO_ALTERNADO;
+	int proximaAlternada = 0;
+	
+	// Presupuesto (por salida)
+	int bytesPorTick = 52;       // 3125 bytes/seg (31250 baudios) a 60 frames por segundo
+	int maxNotasPorTick = 12;
+	int maxTicksEspera = 4;
+	
+	// CC (todos por la salida de efectos)
+	int ultimoValorCC[128];              // último valor enviado, -1 = nunca
+	bool envioPendiente[128] = {false};  // CC de "abrir envío" pedidos en este tick
+	
+	uint64_t colapsados = 0;
 };
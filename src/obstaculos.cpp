@@ -0,0 +1,438 @@
+/*
+--------------------------------------------------------------
+ obstaculos.cpp
+
+ Implementación de la clase Obstaculos: archivo, campo de
+ distancias con signo, consulta de contacto y edición con el mouse.
+--------------------------------------------------------------
+*/
+
+#include "obstaculos.h"
+#include <cfloat>
+
+//--------------------------------------------------------------
+// Distancia de "p" al segmento a-b; en "cercano" deja el punto
+// del segmento más cercano a "p".
+//--------------------------------------------------------------
+
+static float distanciaSegmento(ofVec2f p, ofVec2f a, ofVec2f b, ofVec2f& cercano)
+{
+	ofVec2f ab = b - a;
+	float largo2 = ab.lengthSquared();
+	float t = (largo2 > 0) ? ofClamp((p - a).dot(ab) / largo2, 0, 1) : 0;
+	cercano = a + ab * t;
+	return (p - cercano).length();
+}
+
+// Normal de "desde" hacia "hacia"; si coinciden, una cualquiera
+static ofVec2f direccion(ofVec2f desde, ofVec2f hacia)
+{
+	ofVec2f d = hacia - desde;
+	float largo = d.length();
+	return (largo > 1e-6f) ? d / largo : ofVec2f(0, -1);
+}
+
+//--------------------------------------------------------------
+// distancia(o, p, normal)
+// Distancia con signo (negativa adentro) y normal hacia afuera.
+//--------------------------------------------------------------
+
+float Obstaculos::distancia(const Obstaculo& o, ofVec2f p, ofVec2f& normal)
+{
+	switch(o.tipo) {
+		case OBSTACULO_CIRCULO:
+			normal = direccion(o.puntos[0], p);
+			return (p - o.puntos[0]).length() - o.radio;
+
+		case OBSTACULO_SEGMENTO: {
+			ofVec2f cercano;
+			float d = distanciaSegmento(p, o.puntos[0], o.puntos[1], cercano);
+			normal = direccion(cercano, p);
+			return d - o.radio;
+		}
+
+		case OBSTACULO_POLIGONO: {
+			// Borde más cercano, y adentro/afuera contando cruces de un rayo horizontal
+			float minimo = FLT_MAX;
+			ofVec2f masCercano;
+			bool adentro = false;
+			size_t n = o.puntos.size();
+			for(size_t i = 0, j = n - 1; i < n; j = i++) {
+				const ofVec2f& a = o.puntos[i];
+				const ofVec2f& b = o.puntos[j];
+				ofVec2f cercano;
+				float d = distanciaSegmento(p, a, b, cercano);
+				if(d < minimo) { minimo = d; masCercano = cercano; }
+				if((a.y > p.y) != (b.y > p.y) &&
+				   p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)
+					adentro = !adentro;
+			}
+			normal = adentro ? direccion(p, masCercano) : direccion(masCercano, p);
+			return adentro ? -minimo : minimo;
+		}
+	}
+	normal.set(0, -1);
+	return FLT_MAX;
+}
+
+
+/*
+--------------------------------------------------------------
+ construir(ancho, alto)
+ Recorre los nodos del campo y guarda, para cada uno, el obstáculo
+ más cercano. Es fuerza bruta (nodos x obstáculos), pero se hace
+ solo cuando algo cambia, nunca en un tick.
+--------------------------------------------------------------
+*/
+
+void Obstaculos::construir(int anchoMarco, int altoMarco)
+{
+	ancho = anchoMarco;
+	alto = altoMarco;
+
+	if(lista.empty()) {
+		campo.clear();
+		columnas = filas = 0;
+		return;
+	}
+
+	columnas = ancho / TAM_CELDA + 2;
+	filas = alto / TAM_CELDA + 2;
+	campo.resize(columnas * filas);
+
+	for(int f = 0; f < filas; f++)
+		for(int c = 0; c < columnas; c++) {
+			ofVec2f p(c * TAM_CELDA, f * TAM_CELDA);
+			Nodo& nodo = campo[f * columnas + c];
+			nodo.distancia = FLT_MAX;
+			nodo.obstaculo = -1;
+
+			for(int i = 0; i < (int)lista.size(); i++) {
+				ofVec2f normal;
+				float d = distancia(lista[i], p, normal);
+				if(d < nodo.distancia) {
+					nodo.distancia = d;
+					nodo.nx = normal.x;
+					nodo.ny = normal.y;
+					nodo.obstaculo = i;
+				}
+			}
+		}
+
+	ofLogNotice() << "Campo de obstáculos: " << lista.size() << " obstáculos, "
+				  << columnas << " x " << filas << " nodos";
+}
+
+
+/*
+--------------------------------------------------------------
+ contacto(pos, radio, c)
+ Interpola distancia y normal entre los cuatro nodos que rodean a
+ "pos". Si la distancia es menor que el radio, la pelota toca:
+ se devuelve cuánto entró, hacia dónde salir, y el sonido del
+ obstáculo del nodo más cercano.
+--------------------------------------------------------------
+*/
+
+bool Obstaculos::contacto(ofVec2f pos, float radio, ContactoObstaculo& c) const
+{
+	if(campo.empty()) return false;
+
+	float gx = ofClamp(pos.x / TAM_CELDA, 0, columnas - 1.001f);
+	float gy = ofClamp(pos.y / TAM_CELDA, 0, filas - 1.001f);
+	int x0 = (int)gx, y0 = (int)gy;
+	float fx = gx - x0, fy = gy - y0;
+
+	const Nodo& n00 = campo[y0 * columnas + x0];
+	const Nodo& n10 = campo[y0 * columnas + x0 + 1];
+	const Nodo& n01 = campo[(y0 + 1) * columnas + x0];
+	const Nodo& n11 = campo[(y0 + 1) * columnas + x0 + 1];
+
+	float w00 = (1 - fx) * (1 - fy), w10 = fx * (1 - fy);
+	float w01 = (1 - fx) * fy,       w11 = fx * fy;
+
+	float d = n00.distancia * w00 + n10.distancia * w10 + n01.distancia * w01 + n11.distancia * w11;
+	if(d >= radio) return false;
+
+	ofVec2f normal(n00.nx * w00 + n10.nx * w10 + n01.nx * w01 + n11.nx * w11,
+				   n00.ny * w00 + n10.ny * w10 + n01.ny * w01 + n11.ny * w11);
+	float largo = normal.length();
+	if(largo < 1e-6f) return false;   // justo entre dos caras opuestas: no hay hacia dónde salir
+
+	const Nodo& cercano = campo[(int)(gy + 0.5f) * columnas + (int)(gx + 0.5f)];
+	const Obstaculo& o = lista[cercano.obstaculo];
+
+	c.normal = normal / largo;
+	c.penetracion = radio - d;
+	c.nota = o.nota;
+	c.cc = o.cc;
+	return true;
+}
+
+
+//--------------------------------------------------------------
+// Lista de obstáculos
+//--------------------------------------------------------------
+
+void Obstaculos::agregar(const Obstaculo& o)
+{
+	lista.push_back(o);
+	cambiaron();
+}
+
+void Obstaculos::borrarUltimo()
+{
+	if(lista.empty()) return;
+	lista.pop_back();
+	cambiaron();
+}
+
+void Obstaculos::borrarTodos()
+{
+	lista.clear();
+	cambiaron();
+}
+
+void Obstaculos::cambiaron()
+{
+	construir(ancho, alto);
+	guardar();
+}
+
+
+/*
+--------------------------------------------------------------
+ cargar(ruta) / guardar()
+ Formato de texto, una línea por obstáculo (ver obstaculos.h).
+ Las líneas que no se entienden, o con nota o cc fuera
+ de -1..127, se saltean con un aviso.
+--------------------------------------------------------------
+*/
+
+bool Obstaculos::cargar(const string& ruta)
+{
+	archivo = ruta;
+	lista.clear();
+	if(!ofFile::doesFileExist(ruta, false)) return false;
+
+	ofBuffer buffer = ofBufferFromFile(ruta);
+	int numeroLinea = 0;
+	for(auto& linea : buffer.getLines()) {
+		numeroLinea++;
+		vector<string> campos = ofSplitString(linea, " ", true, true);
+		if(campos.empty() || campos[0][0] == '#') continue;
+
+		Obstaculo o;
+		vector<float> numeros;
+		for(size_t i = 1; i < campos.size(); i++)
+			numeros.push_back(ofToFloat(campos[i]));
+
+		bool valido = numeros.size() >= 2;
+		if(valido) {
+			o.nota = (int)numeros[0];
+			o.cc = (int)numeros[1];
+			// -1 es "sin nota" / "sin cc"; lo demás tiene que entrar en MIDI
+			if(o.nota < -1 || o.nota > 127 || o.cc < -1 || o.cc > 127) {
+				ofLogWarning() << "Obstáculos: nota o cc fuera de -1..127 en la línea " << numeroLinea << " de " << ruta;
+				continue;
+			}
+		}
+
+		if(valido && campos[0] == "circulo" && numeros.size() == 5) {
+			o.tipo = OBSTACULO_CIRCULO;
+			o.puntos.push_back(ofVec2f(numeros[2], numeros[3]));
+			o.radio = numeros[4];
+		}
+		else if(valido && campos[0] == "segmento" && (numeros.size() == 6 || numeros.size() == 7)) {
+			o.tipo = OBSTACULO_SEGMENTO;
+			o.puntos.push_back(ofVec2f(numeros[2], numeros[3]));
+			o.puntos.push_back(ofVec2f(numeros[4], numeros[5]));
+			o.radio = (numeros.size() == 7) ? numeros[6] : GROSOR;
+		}
+		else if(valido && campos[0] == "poligono" && numeros.size() >= 8 && numeros.size() % 2 == 0) {
+			o.tipo = OBSTACULO_POLIGONO;
+			for(size_t i = 2; i < numeros.size(); i += 2)
+				o.puntos.push_back(ofVec2f(numeros[i], numeros[i + 1]));
+		}
+		else {
+			ofLogWarning() << "Obstáculos: no se entiende la línea " << numeroLinea << " de " << ruta;
+			continue;
+		}
+		lista.push_back(o);
+	}
+
+	ofLogNotice() << "Obstáculos: " << lista.size() << " cargados de " << ruta;
+	return true;
+}
+
+bool Obstaculos::guardar()
+{
+	if(archivo.empty()) return false;
+
+	string texto = "# tipo nota cc coordenadas (ver obstaculos.h)\n";
+	for(const Obstaculo& o : lista) {
+		switch(o.tipo) {
+			case OBSTACULO_CIRCULO:  texto += "circulo";  break;
+			case OBSTACULO_SEGMENTO: texto += "segmento"; break;
+			case OBSTACULO_POLIGONO: texto += "poligono"; break;
+		}
+		texto += " " + ofToString(o.nota) + " " + ofToString(o.cc);
+		for(const ofVec2f& p : o.puntos)
+			texto += " " + ofToString(p.x) + " " + ofToString(p.y);
+		if(o.tipo != OBSTACULO_POLIGONO)
+			texto += " " + ofToString(o.radio);
+		texto += "\n";
+	}
+
+	ofBuffer buffer(texto.c_str(), texto.size());
+	return ofBufferToFile(archivo, buffer);
+}
+
+
+//--------------------------------------------------------------
+// draw()
+// Los obstáculos con nota propia toman el color de esa nota,
+// como las pelotas; los que usan la nota de la pelota, gris.
+//--------------------------------------------------------------
+
+void Obstaculos::draw() const
+{
+	for(const Obstaculo& o : lista) {
+		if(o.nota >= 0)
+			ofSetColor(ofColor::fromHsb((o.nota * 8) % 360, 120, 200));
+		else
+			ofSetColor(110);
+
+		switch(o.tipo) {
+			case OBSTACULO_CIRCULO:
+				ofFill();
+				ofDrawCircle(o.puntos[0], o.radio);
+				break;
+
+			case OBSTACULO_SEGMENTO:
+				ofSetLineWidth(o.radio * 2);
+				ofDrawLine(o.puntos[0], o.puntos[1]);
+				ofSetLineWidth(1);
+				break;
+
+			case OBSTACULO_POLIGONO: {
+				ofPolyline borde;
+				for(const ofVec2f& p : o.puntos) borde.addVertex(p);
+				borde.close();
+				ofSetLineWidth(2);
+				borde.draw();
+				ofSetLineWidth(1);
+				break;
+			}
+		}
+	}
+
+	// Lo que se está dibujando con el mouse
+	ofSetColor(255, 255, 255, 160);
+	ofNoFill();
+	if(arrastrando && modo == EDICION_CIRCULO)
+		ofDrawCircle(inicio, (actual - inicio).length());
+	if(arrastrando && modo == EDICION_SEGMENTO)
+		ofDrawLine(inicio, actual);
+	if(modo == EDICION_POLIGONO && !vertices.empty()) {
+		ofPolyline borde;
+		for(const ofVec2f& p : vertices) borde.addVertex(p);
+		borde.addVertex(ofVec2f(ofGetMouseX(), ofGetMouseY()));
+		borde.draw();
+	}
+	ofFill();
+}
+
+
+/*
+--------------------------------------------------------------
+ Edición con el mouse
+  - Círculo: se aprieta en el centro y se arrastra hasta el radio.
+  - Segmento: se aprieta en un extremo y se suelta en el otro.
+  - Polígono: cada click izquierdo agrega un vértice, el derecho
+    lo cierra (con tres vértices o más).
+ Lo dibujado toca su propia nota, según la altura.
+--------------------------------------------------------------
+*/
+
+void Obstaculos::cambiarModo()
+{
+	modo = (ModoEdicionObstaculos)((modo + 1) % NUM_MODOS_EDICION);
+	arrastrando = false;
+	vertices.clear();
+	ofLogNotice() << "Edición de obstáculos: " << nombreModo();
+}
+
+string Obstaculos::nombreModo() const
+{
+	switch(modo) {
+		case EDICION_CIRCULO:  return "círculo";
+		case EDICION_SEGMENTO: return "segmento";
+		case EDICION_POLIGONO: return "polígono";
+		default:               return "no";
+	}
+}
+
+int Obstaculos::notaPorAltura(float y) const
+{
+	return (int)ofMap(y, 0, alto, 96, 24, true);
+}
+
+bool Obstaculos::presionar(float x, float y, int boton)
+{
+	if(modo == EDICION_NINGUNA) return false;
+
+	if(modo == EDICION_POLIGONO) {
+		if(boton == 0) {
+			vertices.push_back(ofVec2f(x, y));
+			return false;
+		}
+		if(vertices.size() < 3) return false;
+
+		Obstaculo o;
+		o.tipo = OBSTACULO_POLIGONO;
+		o.puntos = vertices;
+		o.nota = notaPorAltura(vertices[0].y);
+		vertices.clear();
+		agregar(o);
+		return true;
+	}
+
+	if(boton == 0) {
+		inicio.set(x, y);
+		actual = inicio;
+		arrastrando = true;
+	}
+	return false;
+}
+
+void Obstaculos::arrastrar(float x, float y)
+{
+	if(arrastrando) actual.set(x, y);
+}
+
+bool Obstaculos::soltar(float x, float y)
+{
+	if(!arrastrando) return false;
+	arrastrando = false;
+	actual.set(x, y);
+
+	float largo = (actual - inicio).length();
+	if(largo < TAM_CELDA) return false;   // un click suelto no es un obstáculo
+
+	Obstaculo o;
+	o.nota = notaPorAltura(inicio.y);
+	if(modo == EDICION_CIRCULO) {
+		o.tipo = OBSTACULO_CIRCULO;
+		o.puntos.push_back(inicio);
+		o.radio = largo;
+	}
+	else {
+		o.tipo = OBSTACULO_SEGMENTO;
+		o.puntos.push_back(inicio);
+		o.puntos.push_back(actual);
+		o.radio = GROSOR;
+	}
+	agregar(o);
+	return true;
+}
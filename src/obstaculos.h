@@ -0,0 +1,126 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ obstaculos.h
+
+ Clase Obstaculos
+
+ Obstáculos fijos dentro del marco: círculos, segmentos y
+ polígonos, cargados de un archivo de texto o dibujados con el
+ mouse. Cada uno puede tocar su propia nota y/o mandar su CC
+ cuando una pelota rebota contra él.
+
+ Para no probar cada pelota contra cada obstáculo, se precalcula
+ un campo de distancias con signo sobre todo el marco: una grilla
+ de nodos cada TAM_CELDA píxeles que guarda la distancia al
+ obstáculo más cercano (negativa adentro), la normal hacia afuera
+ y cuál es ese obstáculo. La consulta de una pelota es una
+ interpolación entre los cuatro nodos que la rodean: cuesta lo
+ mismo con un obstáculo que con cien.
+ El campo se recalcula solo cuando cambian los obstáculos o el
+ tamaño del marco (construir()).
+
+ Archivo (una línea por obstáculo, # comenta, nota/cc -1 = no):
+   circulo   nota cc  x y radio
+   segmento  nota cc  x1 y1 x2 y2 [grosor]
+   poligono  nota cc  x1 y1 x2 y2 x3 y3 ...
+
+ Hilos: la simulación solo consulta. Agregar, borrar o cargar se
+ hace desde el hilo del GUI con la simulación sincronizada.
+--------------------------------------------------------------
+*/
+
+enum TipoObstaculo {
+	OBSTACULO_CIRCULO,
+	OBSTACULO_SEGMENTO,
+	OBSTACULO_POLIGONO
+};
+
+struct Obstaculo {
+	TipoObstaculo tipo;
+	vector<ofVec2f> puntos;   // centro / extremos / vértices
+	float radio = 0;          // círculo: radio; segmento: medio grosor
+	int nota = -1;            // nota propia al rebotar, -1 = la de la pelota
+	int cc = -1;              // CC a 127 al rebotar, -1 = ninguno
+};
+
+// Resultado de una consulta que tocó un obstáculo
+struct ContactoObstaculo {
+	ofVec2f normal;           // hacia afuera del obstáculo
+	float penetracion;        // cuánto hay que correr la pelota por la normal
+	int nota;
+	int cc;
+};
+
+// Lo que se está dibujando con el mouse
+enum ModoEdicionObstaculos {
+	EDICION_NINGUNA,
+	EDICION_CIRCULO,
+	EDICION_SEGMENTO,
+	EDICION_POLIGONO,
+	NUM_MODOS_EDICION
+};
+
+class Obstaculos
+{
+public:
+	static const int TAM_CELDA = 4;        // píxeles entre nodos del campo
+	static constexpr float GROSOR = 4;     // medio grosor de los segmentos dibujados
+
+	// Lee el archivo (si existe), y ahí mismo guarda lo que se edite
+	bool cargar(const string& ruta);
+	bool guardar();
+
+	// Recalcula el campo de distancias para un marco de ancho x alto
+	void construir(int ancho, int alto);
+
+	// ¿Un círculo en "pos" de radio "radio" toca algún obstáculo?
+	bool contacto(ofVec2f pos, float radio, ContactoObstaculo& c) const;
+
+	void agregar(const Obstaculo& o);
+	void borrarUltimo();
+	void borrarTodos();
+	int size() const { return (int)lista.size(); }
+	bool estaVacio() const { return lista.empty(); }
+
+	// Dibujo de los obstáculos y de lo que se está editando
+	void draw() const;
+
+	// Edición con el mouse. Devuelven true si cambió algún obstáculo
+	// (hay que sincronizar la simulación antes de llamarlas).
+	void cambiarModo();
+	ModoEdicionObstaculos getModo() const { return modo; }
+	string nombreModo() const;
+	bool presionar(float x, float y, int boton);
+	void arrastrar(float x, float y);
+	bool soltar(float x, float y);
+
+private:
+	struct Nodo {
+		float distancia;
+		float nx, ny;         // normal (gradiente de la distancia)
+		int obstaculo;        // el más cercano, -1 = no hay
+	};
+
+	// Distancia con signo de "p" a un obstáculo, y la normal en ese punto
+	static float distancia(const Obstaculo& o, ofVec2f p, ofVec2f& normal);
+
+	// Nota de un obstáculo dibujado: más arriba, más aguda
+	int notaPorAltura(float y) const;
+
+	// Un cambio: recalcula el campo y lo guarda en el archivo
+	void cambiaron();
+
+	vector<Obstaculo> lista;
+	vector<Nodo> campo;
+	int columnas = 0, filas = 0;          // nodos del campo
+	int ancho = 0, alto = 0;              // marco del campo
+	string archivo;
+
+	ModoEdicionObstaculos modo = EDICION_NINGUNA;
+	bool arrastrando = false;
+	ofVec2f inicio, actual;               // círculo y segmento en edición
+	vector<ofVec2f> vertices;             // polígono en edición
+};
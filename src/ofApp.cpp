@@ -25,14 +25,22 @@
 */
 
 #include "ofApp.h"
+#include "colisiones.h"
+#include "registro.h"
+#include "contadorMemoria.h"
 
 /*
 --------------------------------------------------------------
 setup()
  - Inicializa la aplicación
  - Configura la ventana y el framerate
- - Prepara los framebuffers para dibujar y pixelar las pelotas
+ - Los framebuffers se reservan recién en el primer draw()
+ - Reserva el pool de pelotas con su capacidad máxima
+ - Arranca el hilo de simulación
  - Incializa la GUI y el protcocolo MIDI, y sus parametros respectivos
+ - Los puertos MIDI y la placa de sonido se buscan y abren en segundo
+   plano (DescubridorDispositivos): el primer frame no los espera
+ - Abre el receptor OSC para controlar los parámetros desde afuera
  - Setea variables internas de estado
  --------------------------------------------------------------
  */
@@ -40,28 +48,160 @@ setup()
 
 void ofApp::setup()
 {
+	arranque.marcar("ventana");
 	hacerNacer = false;
 	showGUI = true;
 	info = true;
 	
-	ofSetWindowTitle("Terrorizer");
+	// Registro asincrónico para los mensajes de diagnóstico del frame
+	Registro::iniciar();
+	
+	ofSetWindowTitle(totalParticiones > 1
+					 ? "Terrorizer " + ofToString(indiceParticion + 1) + "/" + ofToString(totalParticiones)
+					 : string("Terrorizer"));
 	ofSetFrameRate(60);
+	
+	// Fuente de tiempo de la simulación: real, o virtual a 1/60 s por tick
+	if(usarRelojVirtual) {
+		relojVirtual.setPaso(1.0 / 60.0);
+		reloj.setFuente(&relojVirtual);
+		ofSetFrameRate(60 * velocidadVirtual);   // los ticks corren más rápido que el tiempo real
+	}
+	else
+		reloj.setFuente(&relojReal);
+	
+	// Ritmo de frames: 60 fps con pelotas, pocos fps en reposo
+	planificador.setup(60, 6);
+	
+	// Calidad visual según lo que cuesta el frame (la prueba de memoria la deja fija)
+	calidad.setPresupuesto(presupuestoFrame);
+	calidad.setActivo(framesPruebaMemoria == 0);
 	ofBackground(0);
 	
-	// Uso de frame buffers para el dibujo y el pixelado
-	fbo.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA); // allocate = reserva memoria para un objeto fbo
-	fboPixelado.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA);
+	// Toda la memoria de las pelotas se reserva acá, una sola vez
+	pelotas.setup(capacidadPelotas, politicaPool);
+	radiosGeneracion.resize(capacidadPelotas);
+	rueda.setup(capacidadPelotas * 2, reloj.actual().numero);
+	vencidos.reserve(capacidadPelotas * 2);
+	
+	// Bus de eventos de la simulación y sus suscriptores, en este orden
+	// Por pelota y por tick, lo que no es rebote: hasta 3 notas en update
+	// (suelta la del obstáculo, la del obstáculo, la propia), 2 Note Off
+	// si se la saca del pool, y nacer o morir. Los rebotes usan el resto.
+	eventos.setup(capacidadPelotas * 14, capacidadPelotas * 6 + 1);
+	eventos.suscribir(&midi);
+	eventos.suscribir(&registroEventos);
+	eventos.suscribir(&destellos);
+	estelas.setup(capacidadPelotas);
+	mallaEstelas.setMode(OF_PRIMITIVE_TRIANGLE_STRIP);
+	
+	// Obstáculos fijos: el campo de distancias se calcula una vez acá
+	obstaculos.cargar(ofToDataPath(archivoObstaculos));
+	obstaculos.construir(ofGetWidth(), ofGetHeight());
+	
+	// Semilla de sesión: todo el azar de la simulación sale de acá
+	if(semillaSesion == 0)
+		semillaSesion = ofGetSystemTimeMicros();
+	ofLogNotice() << "Semilla de sesión: " << semillaSesion << " (repetir con --semilla=" << semillaSesion << ")";
+	
+	// Instantáneas para draw(), con lugar para todas las pelotas del pool
+	Instantanea vacia;
+	vacia.pelotas.resize(capacidadPelotas);
+	vacia.destellos.resize(Destellos::MAX_DESTELLOS);
+	vacia.estela.resize(capacidadPelotas * Estelas::verticesPorPelota());
+	instantaneas.inicializar(vacia);
+	arranque.marcar("pool e instantáneas");
 	
     // Configuración del panel GUI
 	gui.setup("Controles");
 	control.setup(gui, &midi);
+	capaInterfaz.setup(gui, ofGetWidth(), ofGetHeight());
+	
+	// Precarga los presets de data/presets (una sola vez, antes del primer frame)
+	banco.setup(gui, control);
+	arranque.marcar("GUI y presets");
 	
     // inicializa el MIDI (puerto, canal)
-	midi.setup(0, 1);
+	// Salidas MIDI: la primera lleva los CC, salvo que haya una de efectos aparte
+	midi.setup(puertosMidi.empty() ? 0 : puertosMidi[0], 1, &descubridor);
+	for(size_t i = 1; i < puertosMidi.size(); i++)
+		midi.agregarSalida(puertosMidi[i], 1);
+	if(puertoEfectosMidi >= 0)
+		midi.setSalidaEfectos(midi.agregarSalida(puertoEfectosMidi, 1));
+	midi.setRuteo(ruteoMidi);
+	REGISTRO_NOTICE("Salidas MIDI abiertas: {}", midi.getNumSalidas());
+	midi.setPresupuesto(3125 / 60, 12);  // bytes y NoteOn por frame: lo que lleva un cable MIDI a 60 fps
+	
+	// inicializa el receptor OSC (puerto UDP): con partición, uno por proceso
+	osc.setup(9000 + indiceParticion);
+	
+	// Partición: franja de la arena y pase de pelotas por OSC a los procesos vecinos
+	particion.setup(indiceParticion, totalParticiones, puertoParticion);
+	marco.set(0, 0, ofGetWidth(), ofGetHeight());   // después lo sigue windowResized()
+	limitesPelotas = particion.limites(marco);
+	mouseNacimiento.set(ofGetMouseX(), ofGetMouseY());
+	
+	// Program Change para llamar presets (puerto MIDI de entrada 0, cuando aparezca)
+	descubridor.alCambiar([this]{ banco.conectarEntradaMidi(descubridor.nombreEntrada(0)); });
+	
+	// Reloj MIDI externo (--reloj-midi): por número de entrada o por nombre, cuando aparezca
+	if(!entradaRelojMidi.empty())
+		descubridor.alCambiar([this]{
+			string nombre;
+			if(isdigit(entradaRelojMidi[0]))
+				nombre = descubridor.nombreEntrada(ofToInt(entradaRelojMidi));
+			else
+				for(int i = 0; !descubridor.nombreEntrada(i).empty(); i++)
+					if(descubridor.nombreEntrada(i) == entradaRelojMidi) nombre = entradaRelojMidi;
+			relojMidi.conectar(nombre);
+		});
+	
+	// Búsqueda de puertos en segundo plano, y de nuevo cada 2 s por si se enchufa algo
+	descubridor.iniciar(2.0f);
+	
+	// hilo de simulación (se usa si simulacionEnHilo está activo)
+	hilo.setup([this]{ simular(); });
 	
 	// audio
 	soundLevel = 0;
-	ofSoundStreamSetup(0, 1, 44100, 128, 4);
+	// Con el sintetizador interno el stream también tiene salida estéreo
+	if(sintetizadorInterno) {
+		sintetizador.setup(44100);
+		efectos.setup(44100);
+		midi.setSintetizador(&sintetizador);
+	}
+	// La placa de sonido también se abre en segundo plano: hasta que esté,
+	// no hay nivel de entrada ni salida del sintetizador
+	descubridor.encargar("Audio", [this]{
+		ofSoundStreamSettings ajustes;
+		ajustes.numOutputChannels = sintetizadorInterno ? 2 : 0;
+		ajustes.numInputChannels = 1;
+		ajustes.sampleRate = 44100;
+		ajustes.bufferSize = 128;
+		ajustes.numBuffers = 4;
+		ajustes.setInListener(this);
+		if(sintetizadorInterno) ajustes.setOutListener(this);
+		soundStream.setup(ajustes);
+	});
+	arranque.marcar("MIDI, OSC y audio encargados");
+	
+	// Punto de control: retoma la función donde quedó, si hay uno guardado
+	if(intervaloPuntoControl > 0 || retomar)
+		puntoControl.abrir(ofToDataPath(totalParticiones > 1
+										? "puntoControl" + ofToString(indiceParticion + 1) + ".tfc"
+										: string("puntoControl.tfc")), capacidadPelotas);
+	if(retomar)
+		retomarPuntoControl();
+	arranque.marcar("punto de control");
+	
+	// --test-alloc: escena estable sin info en pantalla, con regeneración continua
+	if(framesPruebaMemoria > 0) {
+		info = false;
+		control.regeneracion = true;
+		Parametros par;
+		control.capturar(par);
+		nacenPelotas(par);
+	}
 	
 
 
@@ -71,26 +211,54 @@ void ofApp::setup()
 /*
 --------------------------------------------------------------
  update()
- - Actualiza el estado de los elementos
- - Actualiza valores MIDI y GUI
- - Actualiza el estado de las pelotas, posición, velocidad, notas, rebotes, y colisiones.
- - Si alguna murió inicia la regeneración.
+ - Decide si el frame está en reposo (sin pelotas) y ajusta el ritmo de frames
+ - Aplica los parámetros que llegaron por OSC
+ - Avanza el cambio de preset (morph), si hay uno en curso
+ - Publica la copia plana de los parámetros (Parametros) para la simulación
  - Elige entre dos modos, "Centro" y "Acordes", que definen donde
    nacerán las pelotas en su regeneración proxima:
    "Acordes": salen de un rincón, "Centro": desde el
    centro si está clickeado, si no, desde donde esté el mouse.
+ - Corre un tick de simulación (simular):
+   con simulacionEnHilo, espera al tick anterior y lanza el siguiente en
+   el hilo de simulación, que corre mientras draw() dibuja este.
+   Si no, lo corre acá mismo, como siempre.
  --------------------------------------------------------------
  */
 
 
 void ofApp::update()
 {
-// Actualiza valores MIDI segun el tablero GUI
-	control.update();
+	uint64_t inicio = ofGetElapsedTimeMicros();
 	
-	// audio
-	//float newRad = ofMap( level, 0, 1, 100, 200,true);
-	//level += soundLevel;
+	// Cierra la cuenta de memoria del frame anterior (con TF_CONTAR_MEMORIA)
+	ContadorMemoria::cerrarFrame();
+	if(framesPruebaMemoria > 0)
+		revisarPruebaMemoria();
+	MEDIR_MEMORIA(ETAPA_UPDATE);
+	
+	if(simulacionEnHilo)
+		hilo.esperar();   // el tick anterior tiene que haber terminado antes de tocar los controles
+	
+	descubridor.revisarDemoras();   // avisa si un dispositivo tarda demasiado en abrir
+	
+// Tempo y posición del reloj MIDI, una lectura por frame (el hilo MIDI nunca espera).
+// Enganchado, la dulce espera se cuenta en negras.
+	negrasAnterior = tempoMidi.negras;
+	tempoMidi = relojMidi.leer();
+	dulceEspera = tempoMidi.enganchado ? esperaNegras * 60 / tempoMidi.bpm : dulceEsperaLibre;
+	
+// Reposo: sin pelotas vivas ni morph, baja el ritmo hasta el próximo nacimiento o una entrada.
+// Con reloj virtual no se baja: el tiempo virtual avanza por tick.
+	double proximoNacimiento = (laNada && control.regeneracion) ? tiempoDefuncion + dulceEspera : -1;
+	bool hayActividad = pelotas.size() > 0 || banco.enMorph() || usarRelojVirtual;
+	planificador.actualizar(hayActividad, proximoNacimiento, reloj.actual().segundos);
+	
+// Aplica los parámetros que llegaron por OSC desde el último frame
+	osc.aplicar(control);
+	
+// Preset pedido por teclado o Program Change, y avance del morph
+	banco.update(control, reloj.actual().segundos, control.morph);
 	
 // Estados excluyente, Se elige en el GUI donde van a nacer las pelotas.
 	bool Centro = false;
@@ -102,43 +270,299 @@ void ofApp::update()
 	if(control.acordes && control.acordes != Acordes)
 	   control.centro = false;
 	
-	Centro = control.centro;
-	Acordes = control.acordes;
+// Publica la copia de los parámetros de este frame para la simulación
+	control.publicar();
+	mouseNacimiento.set(ofGetMouseX(), ofGetMouseY());   // la ventana no se consulta desde el hilo
 	
-	bool algunaMurio = false;
-	int pelotasMuertas = 0;
+	if(simulacionEnHilo)
+		hilo.lanzar();
+	else
+		simular();
 	
-// Actualiza el estado individual de las pelotas
+	microsUpdate = ofGetElapsedTimeMicros() - inicio;
+}
+
+
+/*
+--------------------------------------------------------------
+ simular()
+ Un tick de simulación:
+ - Toma la hora del tick (reloj.muestrear), una sola vez
+ - Actualiza valores MIDI según el GUI
+ - Dispara los eventos de la rueda que vencen en este tick:
+   las pelotas muertas vuelven al pool, y la regeneración agendada nace.
+ - Actualiza el estado de las pelotas, posición, velocidad, notas, rebotes, y colisiones.
+ - Si alguna murió agenda la regeneración.
+ - Reparte los eventos del tick a sus suscriptores (MIDI, registro, destellos)
+ - Despacha los mensajes MIDI del frame (procesarTick)
+ - Publica la instantánea que va a dibujar draw()
+ --------------------------------------------------------------
+ */
+
+void ofApp::simular()
+{
+	MEDIR_MEMORIA(ETAPA_SIMULACION);
 	
-	for (int i = 0; i < pelotas.size(); i++) {
-		pelotas[i].update(control.factorVel);
-		
-		if (pelotas[i].isDead()) {
-			algunaMurio = true;
-			pelotasMuertas++;
-		}
+// La simulación no lee los sliders: usa la última copia publicada por el GUI
+	const Parametros& par = control.leerParametros();
+	float factorVel = par.get(PARAM_FACTOR_VEL);
+	
+// Con reloj MIDI la simulación va al tempo: a BPM_REFERENCIA, a la velocidad de siempre
+	if(tempoMidi.enganchado)
+		factorVel *= tempoMidi.bpm / RelojMidi::BPM_REFERENCIA;
+	
+// La hora se lee una sola vez por tick y se reparte a todas las pelotas
+	const Tick& ahora = reloj.muestrear();
+	
+// Actualiza valores MIDI segun el tablero GUI
+	control.update(par);
+	
+	// Envolvente del sintetizador interno: ataque y release en décimas de segundo
+	if(sintetizadorInterno && (par.cambio(PARAM_ATAQUE) || par.cambio(PARAM_RELEASE)))
+		sintetizador.setEnvolvente(par.get(PARAM_ATAQUE) / 10.0f, par.get(PARAM_RELEASE) / 10.0f);
+	
+	// Los mismos sliders de efectos que van por CC, para la cadena interna
+	if(sintetizadorInterno && (par.cambio(PARAM_DISTORSION) || par.cambio(PARAM_FILTRO) ||
+							   par.cambio(PARAM_DELAY) || par.cambio(PARAM_TIEMPO) ||
+							   par.cambio(PARAM_FEEDBACK) || par.cambio(PARAM_REVERB)))
+		efectos.setParametros(par);
+	
+	// Las estelas siguen al delay y al feedback (más cortas si bajó la calidad)
+	estelas.setLargo(par.get(PARAM_DELAY), par.get(PARAM_FEEDBACK), calidad.actual().largoEstela);
+	
+	// audio
+	//float newRad = ofMap( level, 0, 1, 100, 200,true);
+	//level += soundLevel;
+	
+// Eventos agendados que vencen en este tick
+	vencidos.clear();
+	rueda.avanzar(ahora.numero, vencidos);
+	
+// Las pelotas a las que se les terminó la vida vuelven al pool antes de moverse.
+// Si la pelota ya no está (la reemplazó otra, o se borraron todas) el manejador
+// está vencido y el evento no hace nada.
+	bool algunaMurio = false;
+	for (const EventoRueda& e : vencidos) {
+		if (e.tipo != EVENTO_MUERTE) continue;
+		Pelota* p = pelotas.obtener(e.pelota);
+		if (p == nullptr) continue;
+		p->morir(ahora);
+		pelotas.liberar(e.pelota);
+		algunaMurio = true;
 	}
 
-// Registra el momento en que murió la primera pelotas
+// Registra el momento en que murió la primera pelotas y agenda la regeneración
 	if (algunaMurio && !laNada) {
-		tiempoDefuncion = ofGetElapsedTimef();
+		tiempoDefuncion = ahora.segundos;
 		laNada = true;
-		ofLogNotice() << "Número actual de pelotas: " << pelotas.size(); // imprimo nro de pelotas
+		programarRegeneracion(ahora.numero);
+	}
+	
+// Las que llegaron de los procesos vecinos entran al comienzo del tick
+	if (particion.activa())
+		recibirPelotas(ahora, factorVel);
+	
+// Actualiza el estado individual de las pelotas
+	for (int i = 0; i < pelotas.size(); i++)
+		pelotas[i].update(factorVel, ahora);
+	
+// Y las que cruzaron un borde abierto pasan al vecino
+	if (particion.activa())
+		pasarPelotas(ahora);
+	
+// Si se vuelve a prender la regeneración con una espera ya vencida, nace en el próximo tick
+	if (regeneracionPendiente && par.cambio(PARAM_REGENERACION) && par.activo(PARAM_REGENERACION)) {
+		regeneracionPendiente = false;
+		programarRegeneracion(ahora.numero);
+	}
+	
+// Un Start del reloj MIDI arranca una generación nueva, en cuanto el tempo engancha
+	if (tempoMidi.inicios != iniciosMidi) {
+		iniciosMidi = tempoMidi.inicios;
+		nacerEnInicio = true;
+	}
+	if (nacerEnInicio && tempoMidi.enganchado) {
+		nacerEnInicio = false;
+		midi.allNotesOff();
+		nacenPelotas(par);
 	}
-
 	
 // Activa la regeneración continua de nuevas pelotas!
-	if(control.regeneracion) {
-		bool tiempoCumplido = (ofGetElapsedTimef() - tiempoDefuncion >= dulceEspera);
+// Solo vale el evento de la generación que murió: si nació otra entre tanto, se ignora.
+// Con reloj MIDI, además, espera a que empiece una negra.
+	for (const EventoRueda& e : vencidos) {
+		if (e.tipo != EVENTO_REGENERACION || e.dato != numeroGeneracion || !laNada) continue;
 		
-		if (laNada && tiempoCumplido) {
+		if (!par.activo(PARAM_REGENERACION))
+			regeneracionPendiente = true;
+		else if (ahora.segundos - tiempoDefuncion < dulceEspera)
+			programarRegeneracion(ahora.numero);    // venció antes: se agenda lo que falta
+		else if (tempoMidi.enganchado && floor(tempoMidi.negras) == floor(negrasAnterior))
+			rueda.programar(ahora.numero + 1, e);   // todavía no empezó la negra siguiente
+		else {
 			midi.allNotesOff();  // apago las notas
-			nacenPelotas();      // genero las nuevas pelotas
+			nacenPelotas(par);   // genero las nuevas pelotas
 		}
 	}
 	
 // gestiona los choques entre pelotas
-	detectarChoques();
+	detectarChoques(factorVel);
+	
+// Reparte los eventos del tick (MIDI, registro, destellos)
+	eventos.despachar(ahora.numero);
+	
+// Manda al cable lo que se juntó en este frame, dentro del presupuesto MIDI
+	midi.procesarTick();
+	
+// Copia lo que hay que dibujar y lo entrega a draw()
+	publicarInstantanea();
+	
+// Cada tanto, el estado completo al punto de control
+	if(intervaloPuntoControl > 0 && ahora.segundos - ultimoPuntoControl >= intervaloPuntoControl) {
+		guardarPuntoControl(ahora);
+		ultimoPuntoControl = ahora.segundos;
+	}
+}
+
+
+/*
+--------------------------------------------------------------
+ guardarPuntoControl(ahora)
+ Corre al final de un tick, en el hilo de la simulación. Solo copia
+ al archivo mapeado (las pelotas que no cambiaron ni eso) y pide
+ una escritura asíncrona: no espera al disco.
+--------------------------------------------------------------
+*/
+
+void ofApp::guardarPuntoControl(const Tick& ahora)
+{
+	if(!puntoControl.estaAbierto()) return;
+	
+	puntoControl.comenzar();
+	
+	EstadoPelota estado;
+	for(int i = 0; i < pelotas.size(); i++) {
+		pelotas[i].guardarEstado(estado, ahora.numero);
+		puntoControl.escribirPelota(i, estado);
+	}
+	
+	const Parametros& par = control.leerParametros();
+	EstadoSimulacion sim = {};
+	sim.segundos = ahora.segundos;
+	sim.tiempoDefuncion = tiempoDefuncion;
+	sim.numeroGeneracion = numeroGeneracion;
+	sim.semillaSesion = semillaSesion;
+	sim.tick = ahora.numero;
+	sim.cantidadPelotas = pelotas.size();
+	sim.numPelotas = NUM_PELOTAS;
+	sim.laNada = laNada;
+	sim.numParametros = NUM_PARAMETROS;
+	for(int id = 0; id < NUM_PARAMETROS; id++)
+		sim.parametros[id] = par.get(id);
+	
+	puntoControl.terminar(sim);
+}
+
+
+/*
+--------------------------------------------------------------
+ retomarPuntoControl()
+ Se llama en setup(), antes de que arranque la simulación.
+ Vuelve a poner los sliders, las pelotas (con su generador) y el
+ estado de la generación. Los tiempos guardados se corren al reloj
+ actual, así las esperas siguen donde estaban.
+ Notas: las que quedaron colgadas en el sinte externo se apagan
+ todas, y las que estaban sonando al guardar se vuelven a tocar;
+ el NoteOff sale solo en el tick siguiente, como siempre.
+--------------------------------------------------------------
+*/
+
+bool ofApp::retomarPuntoControl()
+{
+	const EstadoSimulacion* sim = puntoControl.leerSimulacion();
+	const EstadoPelota* guardadas = puntoControl.leerPelotas();
+	if(sim == nullptr || guardadas == nullptr) return false;
+	
+	for(int id = 0; id < NUM_PARAMETROS && id < (int)sim->numParametros; id++)
+		control.setParametro(id, sim->parametros[id]);
+	
+	double desplazamiento = reloj.actual().segundos - sim->segundos;
+	tiempoDefuncion = sim->tiempoDefuncion + desplazamiento;
+	numeroGeneracion = sim->numeroGeneracion;
+	semillaSesion = sim->semillaSesion;
+	NUM_PELOTAS = sim->numPelotas;
+	laNada = sim->laNada;
+	
+	midi.allNotesOff();
+	
+	pelotas.liberarTodas();
+	rueda.vaciar();
+	uint64_t tick = reloj.actual().numero;
+	marco.set(0, 0, ofGetWidth(), ofGetHeight());
+	limitesPelotas = particion.limites(marco);
+	for(int i = 0; i < sim->cantidadPelotas; i++) {
+		ManejadorPelota manejador;
+		Pelota* p = pelotas.crear(&manejador);
+		if(p == nullptr) break;
+		p->cargarEstado(guardadas[i], limitesPelotas, &eventos, desplazamiento, tick);
+		p->setObstaculos(&obstaculos);
+		rueda.programar(p->tickMuerte(), { EVENTO_MUERTE, manejador });
+		if(p->estaSonando())
+			midi.sendNoteOn(p->getNota(), 100, p->getSalida());
+	}
+	if(laNada)
+		programarRegeneracion(tick);
+	
+	REGISTRO_NOTICE("Retomado el punto de control del tick {}: {} pelotas", sim->tick, pelotas.size());
+	return true;
+}
+
+
+//--------------------------------------------------------------
+// publicarInstantanea()
+// Llena la copia de escritura del triple buffer con las pelotas
+// visibles, sus estelas y los destellos. Los vectores ya tienen
+// la capacidad del pool: no pide memoria.
+//--------------------------------------------------------------
+
+void ofApp::publicarInstantanea()
+{
+	Instantanea& inst = instantaneas.escritura();
+	inst.cantidad = 0;
+	inst.tick = reloj.actual().numero;
+	
+	inst.cantidadEstela = 0;
+	
+	for (int i = 0; i < pelotas.size(); i++) {
+		// La historia se anota siempre, aunque la estela esté apagada
+		ManejadorPelota m = pelotas.getManejador(i);
+		estelas.registrar(m.indice, m.generacion, pelotas[i].getPos());
+		
+		if (pelotas[i].visual(inst.pelotas[inst.cantidad], inst.tick)) {
+			const PelotaVisual& v = inst.pelotas[inst.cantidad];
+			estelas.construir(m.indice, v.radio, v.color, inst.estela, inst.cantidadEstela);
+			inst.cantidad++;
+		}
+	}
+	
+	destellos.visual(inst, inst.tick);
+	
+	instantaneas.publicar();
+}
+
+
+//--------------------------------------------------------------
+// sincronizarSimulacion()
+// Los eventos (teclado, ventana) llegan mientras el hilo de
+// simulación puede estar corriendo. Antes de tocar las pelotas,
+// el MIDI o los controles desde un evento, se espera a que termine.
+// Hasta el próximo update() no se lanza otro tick.
+//--------------------------------------------------------------
+
+void ofApp::sincronizarSimulacion()
+{
+	if(simulacionEnHilo)
+		hilo.esperar();
 }
 
 
@@ -148,8 +572,12 @@ void ofApp::update()
 // -----------------------------------------------
 void ofApp::windowResized(int w, int h)
 {
+	sincronizarSimulacion();
 	fbo.allocate(w, h, GL_RGBA);
+	capaInterfaz.redimensionar(w, h);
 	marco.set(0, 0, w, h);
+	limitesPelotas = particion.limites(marco);
+	obstaculos.construir(w, h);
 }
 
 
@@ -160,7 +588,9 @@ draw()
  
 Dibuja:
  - El fondo en base a los efecto de la distorsion
- - Las pelotas en un FBO
+ - Las pelotas en un FBO, desde la última instantánea publicada por simular()
+   (en reposo se presenta el FBO guardado, sin volver a dibujarlo)
+ - El GUI y la info desde su capa guardada, redibujada solo cuando cambian
  - El pixelado según la distor y la reverb
  - El panel GUI
  - E información general en texto
@@ -169,6 +599,10 @@ Dibuja:
 
 void ofApp::draw()
 {
+	MEDIR_MEMORIA(ETAPA_DRAW);
+	uint64_t inicio = ofGetElapsedTimeMicros();
+	calidad.empezarGpu();
+	
 	float distorsion = control.distorsion;
 	float reverb = control.reverb;
 	
@@ -176,157 +610,449 @@ void ofApp::draw()
 	float r = ofMap(distorsion, 0, 11, 0, 150);
 	ofBackground(r/2, 0, 0);
 	
+	// El FBO de las pelotas se reserva recién acá, en el primer frame
+	// (el pixelado se reserva a su tamaño cuando se usa)
+	if(!fbo.isAllocated())
+		fbo.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA);
+	
+	// En reposo no hay pelotas: se presenta la última imagen guardada en el FBO
+	if(!planificador.redibujarPelotas()) {
+		ofSetColor(255);
+		ofEnableAlphaBlending();
+		fbo.draw(0, 0, ofGetWidth(), ofGetHeight());
+		ofDisableAlphaBlending();
+	}
+	else {
+		planificador.pelotasDibujadas();
+		dibujarPelotas(distorsion);
+	}
+	
+	dibujarInterfaz();
+	
+	arranque.primerFrame();   // la primera vez informa el tiempo hasta el primer frame
+	
+	calidad.terminarGpu();
+	
+	// Lo que costó este frame decide la calidad de los próximos: lo más lento entre
+	// la CPU y la GPU. El intervalo real entre frames incluye la espera de
+	// ofSetFrameRate, así que solo cuenta cuando el frame llegó tarde (en reposo
+	// los frames van lentos a propósito y no se mide).
+	if(planificador.getEstado() == PlanificadorFrames::ACTIVO) {
+		float costo = max((microsUpdate + ofGetElapsedTimeMicros() - inicio) / 1000.0f, calidad.getMilisegundosGpu());
+		float intervalo = ofGetLastFrameTime() * 1000;
+		if(intervalo > 1250.0f / max(ofGetTargetFrameRate(), 1.0f))
+			costo = max(costo, intervalo);
+		if(calidad.medir(costo))
+			aplicarCalidad();
+	}
+}
+
+
+//--------------------------------------------------------------
+// dibujarPelotas(distorsion)
+// La última instantánea (obstáculos, estelas, pelotas y destellos)
+// en el FBO, a la escala del nivel de calidad, y el FBO a la
+// pantalla: pixelado por la distor y por la reverb, o tal cual.
+//--------------------------------------------------------------
+
+void ofApp::dibujarPelotas(float distorsion)
+{
+	// Con la calidad baja, las pelotas se dibujan en un FBO más chico
+	float escala = calidad.actual().escalaFbo;
+	int anchoFbo = ofGetWidth() * escala;
+	int altoFbo = ofGetHeight() * escala;
+	if(fbo.getWidth() != anchoFbo || fbo.getHeight() != altoFbo)
+		fbo.allocate(anchoFbo, altoFbo, GL_RGBA);
+	
 	// Dibujar pelotas en FBO normal (no pixelado)
-	 fbo.begin();
-	 ofClear(0, 0, 0, 0);
+	fbo.begin();
+	ofClear(0, 0, 0, 0);
+	ofPushMatrix();
+	ofScale(escala, escala);
+	
+	obstaculos.draw();
+	
+	const Instantanea& inst = instantaneas.lectura();   // último tick simulado completo
 	
-	 for(int i = 0; i < pelotas.size(); i++)
-		 pelotas[i].draw();
-	 fbo.end();
+	// Las estelas, debajo de las pelotas, en una sola llamada
+	if(inst.cantidadEstela > 0) {
+		mallaEstelas.clear();
+		for(int i = 0; i < inst.cantidadEstela; i++) {
+			const VerticeEstela& v = inst.estela[i];
+			mallaEstelas.addVertex(ofVec3f(v.x, v.y, 0));
+			mallaEstelas.addColor(v.color);
+		}
+		mallaEstelas.draw();
+	}
+	
+	ofFill();
+	for(int i = 0; i < inst.cantidad; i++) {
+		const PelotaVisual& p = inst.pelotas[i];
+		ofSetColor(p.color);
+		ofDrawCircle(p.x, p.y, p.radio);
+	}
+	ofNoFill();
+	for(int i = 0; i < inst.cantidadDestellos; i++) {
+		const DestelloVisual& d = inst.destellos[i];
+		ofSetColor(d.color);
+		ofDrawCircle(d.x, d.y, d.radio);
+	}
+	ofFill();
+	ofPopMatrix();
+	fbo.end();
 	
 	// De acá en adelante, se produce el pixelado de las pelotitas
-	 ofSetColor(255);
-	 ofEnableAlphaBlending(); // activa transparencia
-	
-	 //pixelado por distor
-	 if(distorsion > 1)
-	 {
-	 float pixelFactor = ofMap(distorsion, 1, 11, 1.0, 0.1);
-	 // Calcular el tamaño del nuevo marco según la distorsión
-	 int lowW = ofGetWidth() * pixelFactor;
-	 int lowH = ofGetHeight() * pixelFactor;
-	 // Re-alloca (reserva memoria) el FBO pixelado con el nuevo ajuste de tamaño
-	 if(fboPixelado.getWidth() != lowW || fboPixelado.getHeight() != lowH)
-		 fboPixelado.allocate(lowW, lowH, GL_RGBA);
-	 
-	 // Dibujar FBO original en un FBO mas chico
-	 fboPixelado.begin();        // comienzo
-	 ofClear(0, 0, 0, 0);        // limpia el buffer
-	 fbo.draw(0, 0, lowW, lowH); // dibuja encima
-	 fboPixelado.end();          // termino
-		 
-	 // Escalar el FBO pequeño al tamaño actual,
-	 // Usa pixelado de cuadraditos nítidos: GL_NEAREST
-	 fboPixelado.getTexture().setTextureMinMagFilter(GL_NEAREST, GL_NEAREST); //
-	 fboPixelado.draw(0, 0, ofGetWidth(), ofGetHeight());
-	 
-	 }
-	
-	 // Pixelado por Reverb
-	 if(control.reverb > 10) {
-	 float pixelFactor = ofMap(control.reverb, 10, 100, 1.0, 0.02);
-	 int lowW = ofGetWidth() * pixelFactor;
-	 int lowH = ofGetHeight() * pixelFactor;
-		 
-	 if(fboPixelado.getWidth() != lowW || fboPixelado.getHeight() != lowH)
-		 fboPixelado.allocate(lowW, lowH, GL_RGBA);
-	 
-	 fboPixelado.begin();
-	 ofClear(0, 0, 0, 0);
-	 fbo.draw(0, 0, lowW, lowH);
-	 fboPixelado.end();
-	 // Uso de un pixelado de bordes suaves y blureados: GL_LINEAR
-	 fboPixelado.getTexture().setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
-	 fboPixelado.draw(0, 0, ofGetWidth(), ofGetHeight());
-	 
-	 }
-	 else
-	 {
-	 // sin pixelado
-	 fbo.draw(0, 0, ofGetWidth(), ofGetHeight());
-	 }
+	ofSetColor(255);
+	ofEnableAlphaBlending(); // activa transparencia
+	
+	//pixelado por distor
+	if(distorsion > 1) {
+		float pixelFactor = ofMap(distorsion, 1, 11, 1.0, 0.1);
+		// Calcular el tamaño del nuevo marco según la distorsión
+		int lowW = ofGetWidth() * pixelFactor;
+		int lowH = ofGetHeight() * pixelFactor;
+		// Re-alloca (reserva memoria) el FBO pixelado con el nuevo ajuste de tamaño
+		if(fboPixelado.getWidth() != lowW || fboPixelado.getHeight() != lowH)
+			fboPixelado.allocate(lowW, lowH, GL_RGBA);
+		
+		// Dibujar FBO original en un FBO mas chico
+		fboPixelado.begin();        // comienzo
+		ofClear(0, 0, 0, 0);        // limpia el buffer
+		fbo.draw(0, 0, lowW, lowH); // dibuja encima
+		fboPixelado.end();          // termino
+		
+		// Escalar el FBO pequeño al tamaño actual,
+		// Usa pixelado de cuadraditos nítidos: GL_NEAREST
+		fboPixelado.getTexture().setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+		fboPixelado.draw(0, 0, ofGetWidth(), ofGetHeight());
+	}
+	
+	// Pixelado por Reverb
+	if(control.reverb > 10) {
+		float pixelFactor = ofMap(control.reverb, 10, 100, 1.0, 0.02);
+		int lowW = ofGetWidth() * pixelFactor;
+		int lowH = ofGetHeight() * pixelFactor;
+		
+		if(fboPixelado.getWidth() != lowW || fboPixelado.getHeight() != lowH)
+			fboPixelado.allocate(lowW, lowH, GL_RGBA);
+		
+		fboPixelado.begin();
+		ofClear(0, 0, 0, 0);
+		fbo.draw(0, 0, lowW, lowH);
+		fboPixelado.end();
+		// Uso de un pixelado de bordes suaves y blureados: GL_LINEAR
+		fboPixelado.getTexture().setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
+		fboPixelado.draw(0, 0, ofGetWidth(), ofGetHeight());
+	}
+	else {
+		// sin pixelado
+		fbo.draw(0, 0, ofGetWidth(), ofGetHeight());
+	}
 	
 	ofDisableAlphaBlending(); // Desactivo transparencia
+}
+
+
+//--------------------------------------------------------------
+// aplicarCalidad()
+// Lo que depende del nivel y no se lee en cada frame: la resolución
+// de los círculos y el ritmo del GUI. La escala del FBO la toma draw()
+// y el largo de las estelas simular(), del nivel actual.
+//--------------------------------------------------------------
+
+void ofApp::aplicarCalidad()
+{
+	const NivelCalidad& n = calidad.actual();
+	ofSetCircleResolution(n.resolucionCirculo);
+	capaInterfaz.setIntervalo(n.framesInterfaz);
+	REGISTRO_NOTICE("Calidad visual {} (frame de {} ms, presupuesto {} ms)",
+					calidad.getNivel(), calidad.getPromedio(), calidad.getPresupuesto());
+}
+
+
+//--------------------------------------------------------------
+// dibujarInterfaz()
+// GUI y mensaje informativo: se dibujan en su capa solo si algo cambió
+//--------------------------------------------------------------
+
+void ofApp::dibujarInterfaz()
+{
+	if(!showGUI && !info) return;
+	MEDIR_MEMORIA(ETAPA_INTERFAZ);
+	
+	uint64_t firma = (showGUI ? 1 : 0) | (info ? 2 : 0);
+	if(info) {
+		firma ^= (uint64_t)midi.getDiferidos() << 2;
+		firma ^= (uint64_t)midi.getDescartados() << 22;
+		firma ^= (uint64_t)Registro::getDescartados() << 42;
+		firma ^= eventos.getPerdidos() * 0xC2B2AE3D27D4EB4Full;
+		firma ^= (uint64_t)obstaculos.getModo() << 60;
+		firma ^= (uint64_t)(calidad.getNivel() + 1) * 0x9E3779B97F4A7C15ull;
+		if(particion.activa())
+			firma ^= (particion.getEnviadas() << 4) ^ (particion.getRecibidas() << 24) ^
+					 (particion.getPerdidas() << 44) ^ (particion.getDesordenadas() << 54);
+		if(ContadorMemoria::activo())
+			firma ^= (uint64_t)(ofGetElapsedTimeMillis() / 1000) << 8;   // la cuenta de memoria, una vez por segundo
+		if(relojMidi.estaConectado())
+			firma ^= ((uint64_t)tempoMidi.negras << 12) ^ ((uint64_t)(tempoMidi.bpm * 10) << 32) ^ tempoMidi.enganchado;  // una vez por negra
+	}
+	
+	if(capaInterfaz.hayQueRedibujar(firma)) {
+		capaInterfaz.begin();
+		// Dibujo del GUI
+		if ( showGUI ) gui.draw();
+		
+		// Mensaje informativo
+		if(info) {
+			ofSetColor(255);
+			ofDrawBitmapString(control.mensaje(), 10, ofGetHeight() - 54);
+			ofDrawBitmapString("MIDI diferidas: " + ofToString(midi.getDiferidos()) +
+							   "  descartadas: " + ofToString(midi.getDescartados()) +
+							   "  registro perdido: " + ofToString(Registro::getDescartados()) +
+							   "  eventos perdidos: " + ofToString(eventos.getPerdidos()), 10, ofGetHeight() - 74);
+			if(obstaculos.getModo() != EDICION_NINGUNA)
+				ofDrawBitmapString("Dibujando obstáculos: " + obstaculos.nombreModo() +
+								   " (" + ofToString(obstaculos.size()) + ")", 10, ofGetHeight() - 94);
+			if(ContadorMemoria::activo())
+				ofDrawBitmapString(textoMemoria(), 10, ofGetHeight() - 114);
+			if(relojMidi.estaConectado())
+				ofDrawBitmapString(tempoMidi.enganchado
+								   ? "Reloj MIDI: " + ofToString(tempoMidi.bpm, 1) + " bpm, negra " + ofToString((int)tempoMidi.negras)
+								   : string("Reloj MIDI: esperando pulsos"), 10, ofGetHeight() - 134);
+			ofDrawBitmapString(calidad.describir(), 10, ofGetHeight() - 174);
+			if(particion.activa())
+				ofDrawBitmapString("Franja " + ofToString(particion.getIndice() + 1) + "/" + ofToString(particion.getTotal()) +
+								   ": enviadas " + ofToString(particion.getEnviadas()) +
+								   "  recibidas " + ofToString(particion.getRecibidas()) +
+								   "  perdidas " + ofToString(particion.getPerdidas()) +
+								   "  desordenadas " + ofToString(particion.getDesordenadas()), 10, ofGetHeight() - 154);
+		}
+		capaInterfaz.end();
+	}
+	capaInterfaz.draw();
+}
+
+
+//--------------------------------------------------------------
+// textoMemoria()
+// Duración del último frame y pedidos de memoria de cada etapa en
+// ese frame, para la info en pantalla (con TF_CONTAR_MEMORIA).
+//--------------------------------------------------------------
+
+string ofApp::textoMemoria()
+{
+	const ConteoMemoria& f = ContadorMemoria::ultimoFrame();
+	string texto = "frame " + ofToString(ofGetLastFrameTime() * 1000, 1) + " ms | new por frame:";
+	for(int e = ETAPA_UPDATE; e < NUM_ETAPAS; e++)
+		texto += string(" ") + ContadorMemoria::nombre(e) + " " + ofToString(f.asignaciones[e]) +
+				 " (" + ofToString(f.bytes[e]) + " B)";
+	return texto;
+}
+
+
+/*
+--------------------------------------------------------------
+ revisarPruebaMemoria()
+ Modo --test-alloc: después de calentamientoMemoria frames (la
+ escena ya reservó todo lo que necesita), ningún frame puede pedir
+ memoria en update, simulación, draw, interfaz o audio. Al terminar
+ los framesPruebaMemoria frames medidos informa y sale con 0 si no
+ hubo pedidos, o con 1 si los hubo.
+ Durante la medición no se registra nada: registrar también pide.
+--------------------------------------------------------------
+*/
+
+void ofApp::revisarPruebaMemoria()
+{
+	framePruebaMemoria++;
+	if(framePruebaMemoria <= calentamientoMemoria) return;
 	
-	// Dibujo del GUI
-	if ( showGUI ) gui.draw();
+	const ConteoMemoria& f = ContadorMemoria::ultimoFrame();
+	if(f.asignacionesFrame() > 0) {
+		framesConPedidos++;
+		if(primerFrameConPedidos == 0) primerFrameConPedidos = framePruebaMemoria;
+		for(int e = 0; e < NUM_ETAPAS; e++) {
+			pedidosPrueba.asignaciones[e] += f.asignaciones[e];
+			pedidosPrueba.bytes[e] += f.bytes[e];
+		}
+	}
 	
-	// Mensaje informativo
-	if(info) ofDrawBitmapString(control.mensaje(), 10, ofGetHeight() - 40);
+	if(framePruebaMemoria < calentamientoMemoria + framesPruebaMemoria) return;
+	
+	if(framesConPedidos == 0)
+		ofLogNotice("test-alloc") << "OK: " << framesPruebaMemoria << " frames sin pedir memoria (después de "
+								  << calentamientoMemoria << " de calentamiento)";
+	else {
+		ofLogError("test-alloc") << "FALLA: " << framesConPedidos << " de " << framesPruebaMemoria
+								 << " frames pidieron memoria, el primero fue el frame " << primerFrameConPedidos;
+		for(int e = ETAPA_UPDATE; e < NUM_ETAPAS; e++)
+			if(pedidosPrueba.asignaciones[e] > 0)
+				ofLogError("test-alloc") << "  " << ContadorMemoria::nombre(e) << ": "
+										 << pedidosPrueba.asignaciones[e] << " pedidos, " << pedidosPrueba.bytes[e] << " bytes";
+	}
+	ofExit(framesConPedidos == 0 ? 0 : 1);
 }
 
 
 /*
 -----------------------------------------------
-nacenPelotas()
- - Limpia el vector pelotas, segun el GUI
- - Calcula la cantidad incial de pelotas
+nacenPelotas(par)
+ - Lee los parámetros de la copia "par", no de los sliders
+ - Libera todas las pelotas del pool, segun el GUI
+ - Toma un flujo de azar propio para la generación (semilla de sesión + número de generación)
+ - Calcula la cantidad incial de pelotas y todos sus radios de una vez
  - Define radio, vida, notas, escala y posicion inicial
- - Crea cada pelota y la agrego al vector
+ - Toma cada pelota de un lugar libre del pool. Si el pool está lleno
+   y la política es rechazar, las que sobran no nacen.
 -----------------------------------------------
  */
 
-void ofApp::nacenPelotas()
+void ofApp::nacenPelotas(const Parametros& par)
 {
 	
-	ofLogNotice() << "resetPelotas() -> limpiando y creando nuevas pelotas";
-	
+	// Lo que sonó en este tick sale antes de apagar todo
+	eventos.despachar(reloj.actual().numero);
 	midi.allNotesOff();
 	
-	if(!control.sumar)
-		pelotas.clear();
+	if(!par.activo(PARAM_SUMAR))
+		pelotas.liberarTodas();
 	
-	// Configura el o el espacio donde vivirán las pelotas
-	marco.set( 0, 0,ofGetWidth(),ofGetHeight());
+	// El espacio donde vivirán las pelotas es "marco" (y limitesPelotas, sin paredes entre
+	// franjas): lo fijan setup() y windowResized() desde el hilo del GUI, no se lee la ventana acá
+	
+	// Cada generación usa su propio flujo de números al azar, derivado de la semilla de sesión
+	Azar azar = Azar::flujo(semillaSesion, numeroGeneracion++);
 	
 	// Determina el numero de pelotas
-	if (control.random)
-		NUM_PELOTAS = (int)ofRandom(1,12);
+	if (par.activo(PARAM_RANDOM))
+		NUM_PELOTAS = (int)azar.uniforme(1,12);
 	else
-		NUM_PELOTAS = control.rangoRandom;
+		NUM_PELOTAS = par.getInt(PARAM_RANGO_RANDOM);
+	NUM_PELOTAS = min(NUM_PELOTAS, (int)radiosGeneracion.size());
+	
+	EventoSimulacion generacion;
+	generacion.tipo = SIM_GENERACION;
+	generacion.dato = (uint32_t)numeroGeneracion;
+	generacion.valor = NUM_PELOTAS;
+	eventos.publicar(generacion);
 	
-	ofLogNotice() << "Nuevo NUM_PELOTAS: " << NUM_PELOTAS;
+	// Todos los radios de la generación de una vez
+	azar.llenarUniforme(radiosGeneracion.data(), NUM_PELOTAS, 10.0f, 50.0f);
 
-	int tipoEscala = control.tipoDeEscala;
+	int tipoEscala = par.getInt(PARAM_TIPO_ESCALA);
+	uint64_t rechazadasAntes = pelotas.getRechazadas();
+	uint64_t tick = reloj.actual().numero;   // nacen en este tick; se mueven desde el próximo
+	
+	// Con reloj MIDI la vida va en negras enteras. La vida baja 2 por tick, y con
+	// pelotas vivas los ticks van al ritmo activo del planificador: una negra
+	// vale 2 * fps * 60 / bpm (a BPM_REFERENCIA y 60 fps, 60)
+	int vida = par.getInt(PARAM_FACTOR_VITAL);
+	if(tempoMidi.enganchado) {
+		double fps = planificador.getFpsActivo();
+		int negras = max(1, (int)round(vida * RelojMidi::BPM_REFERENCIA / (120.0 * fps)));
+		vida = (int)round(negras * 120.0 * fps / tempoMidi.bpm);
+	}
 	
 	// Creo cada pelota
 	for (int i = 0; i < NUM_PELOTAS; i++) {                           // crea las pelotas
 		
-		float radio = ofRandom(10.0f,50.0f);
+		float radio = radiosGeneracion[i];
 		float& radioRefe = radio;
 		
 		int nota = control.escalas(tipoEscala, radioRefe);
-		int vida = control.factorVital;
 		 
-		Pelota p;                                                     // crea un objeto de la clase Pelota
-		p.setup(marco, &midi, nota, radio, vida);                     // setup del objeto
+		ManejadorPelota manejador;
+		Pelota* p = pelotas.crear(&manejador);                        // toma un lugar libre del pool
+		if(p == nullptr) break;                                       // pool lleno: no nacen más
+		p->setup(limitesPelotas, &eventos, nota, radio, vida, azar.siguiente()); // setup del objeto, con su semilla
+		p->nacer(tick);
+		p->setObstaculos(&obstaculos);
+		rueda.programar(p->tickMuerte(), { EVENTO_MUERTE, manejador }); // su muerte queda agendada
+		p->setSalida(midi.elegirSalida(Controles::gradoEscala(radio), radio));
 		
 		// Posición inicial según el modo elegido
-		if(control.acordes)
-			p.pos.set(ofGetWidth() , 0);         // Configuración del origen de las pelotas
+		if(par.activo(PARAM_ACORDES))
+			p->pos.set(marco.getRight(), 0);     // Configuración del origen de las pelotas
 		else {
-			if(control.centro)
-				p.setPos(marco.getCenter());
+			if(par.activo(PARAM_CENTRO))
+				p->setPos(marco.getCenter());
 			else
-				p.pos.set(ofGetMouseX(), ofGetMouseY());
+				p->setPos(mouseNacimiento);
 		}
+		p->posAnterior = p->pos;                 // recién nacida: todavía no recorrió nada
 		
-		pelotas.push_back(p);
+		EventoSimulacion nacimiento;
+		nacimiento.tipo = SIM_NACIMIENTO;
+		nacimiento.nota = nota;
+		nacimiento.salida = p->getSalida();
+		nacimiento.x = p->pos.x;
+		nacimiento.y = p->pos.y;
+		nacimiento.valor = radio;
+		eventos.publicar(nacimiento);
 		
 		control.infoPelotas(i, radio, nota);             // imprime informacion sobre cada pelota
 	}
 	
 	control.nombreEscalas(tipoEscala);  //imprime el nombre de la escala
 	
+	if(pelotas.getRechazadas() > rechazadasAntes)
+		REGISTRO_WARNING("Pool lleno ({}), {} pelotas no nacieron",
+						 pelotas.getCapacidad(), pelotas.getRechazadas() - rechazadasAntes);
+	
 	laNada = false;                     // Hay pelotas, la nada ya no es Nada.
+	regeneracionPendiente = false;
 	
 }
 
 
+//--------------------------------------------------------------
+// programarRegeneracion(tick)
+// Agenda el nacimiento de la próxima generación para cuando pase
+// la dulce espera. Los ticks no tienen ritmo fijo (en reposo van a
+// fpsReposo), así que lo que falta se pasa a ticks con el ritmo más
+// bajo: el evento vence a tiempo o antes, nunca después, y al vencer
+// antes se vuelve a agendar con lo que queda (ver simular()).
+// El evento lleva el número de generación: si antes nace otra
+// (barra espaciadora), queda sin efecto.
+//--------------------------------------------------------------
+
+void ofApp::programarRegeneracion(uint64_t tick)
+{
+	double falta = tiempoDefuncion + dulceEspera - reloj.actual().segundos;
+	EventoRueda e = { EVENTO_REGENERACION };
+	e.dato = numeroGeneracion;
+	rueda.programar(tick + max<uint64_t>(1, (uint64_t)ceil(falta * planificador.getFpsReposo())), e);
+}
+
+
 /*
 -----------------------------------------------
 
  detectarColisiones()
  
-  Compara las pelotas de a pares y si se acercan a una distancia menor a la suma de sus radios, chocan.
+  Compara las pelotas de a pares mirando todo el recorrido del frame,
+  desde getPosAnterior() hasta getPos(). Si en algún momento del recorrido
+  la distancia llega a la suma de sus radios, chocan (tiempoImpactoCirculos).
   Entonces:
+   - Se llevan las dos pelotas al punto de contacto
+   - Intercambian velocidades
+   - Recorren con la velocidad nueva lo que les faltaba del frame
+  Así las pelotas rápidas no se atraviesan entre un frame y otro.
+  
+  La prueba barrida supone que cada pelota fue en línea recta. Si una
+  rebotó en una pared o la empujó un obstáculo en alguno de sus
+  sub-pasos (Pelota::seDesvio), su camino no es la cuerda, y para ese
+  par solo vale la prueba discreta al final del tick.
+  
+  Si ya estaban solapadas al comenzar el frame (por ejemplo al nacer
+  todas en el mismo punto) se usa la prueba discreta de siempre:
    - Intercambian velocidades
    - Se separan ligeramente las pelotas para evitar pegado
 --------------------------------------------------------------
 */
 
 
-void ofApp::detectarChoques()
+void ofApp::detectarChoques(float factorVel)
 {
 	// Compara la pelota i con todas las demás
 	for(int i = 0; i < pelotas.size(); i++) {
@@ -334,21 +1060,51 @@ void ofApp::detectarChoques()
 		
 			ofVec2f pos1 = pelotas[i].getPos();
 			ofVec2f pos2 = pelotas[j].getPos();
+			ofVec2f ant1 = pelotas[i].getPosAnterior();
+			ofVec2f ant2 = pelotas[j].getPosAnterior();
 			float r1 = pelotas[i].getRadio();
 			float r2 = pelotas[j].getRadio();
+			float sumaRadios = r1 + r2;
+			
+			ofVec2f vel1 = pelotas[i].getVel();
+			ofVec2f vel2 = pelotas[j].getVel();
+			
+			// Prueba barrida: ¿se tocaron durante el recorrido? Solo vale si las dos fueron
+			// en línea recta; si una rebotó en el tick, la cuerda no es su camino.
+			float t = -1;
+			if (!pelotas[i].seDesvio() && !pelotas[j].seDesvio())
+				t = tiempoImpactoCirculos(ant1, pos1 - ant1, ant2, pos2 - ant2, sumaRadios);
+			
+			if (t >= 0) {
+				ofVec2f contacto1 = ant1 + (pos1 - ant1) * t;
+				ofVec2f contacto2 = ant2 + (pos2 - ant2) * t;
+				publicarContacto((contacto1 * r2 + contacto2 * r1) / sumaRadios, vel1, vel2);
+				
+				// Intercambiar velocidades (rebote simple) y terminar el frame con ellas
+				pelotas[i].setVel(vel2);
+				pelotas[j].setVel(vel1);
+				pelotas[i].setPos(contacto1 + vel2 * factorVel * (1 - t));
+				pelotas[j].setPos(contacto2 + vel1 * factorVel * (1 - t));
+				
+				// ese resto no pasa por moverConRebotes: que no atraviese las paredes
+				pelotas[i].acotarAlMarco();
+				pelotas[j].acotarAlMarco();
+				
+				// el resto del recorrido arranca en el contacto
+				pelotas[i].posAnterior = contacto1;
+				pelotas[j].posAnterior = contacto2;
+				continue;
+			}
 			
 			float distancia = pos1.distance(pos2);
-			float sumaRadios = r1 + r2;
 			
 			// Si la distancia es menor que la suma de radios, chocan
 			if (distancia < sumaRadios) {
 				
 				ofVec2f direccion = (pos2 - pos1).normalize();
+				publicarContacto(pos1 + direccion * r1, vel1, vel2);
 				
 				// Intercambiar velocidades (rebote simple)
-				ofVec2f vel1 = pelotas[i].getVel();
-				ofVec2f vel2 = pelotas[j].getVel();
-				
 				pelotas[i].setVel(vel2);
 				pelotas[j].setVel(vel1);
 				
@@ -358,20 +1114,129 @@ void ofApp::detectarChoques()
 				// si separacion tuviera el mismo signo, las pelotas marcharían juntas y solapadas.
 				pelotas[i].setPos(pos1 - separacion);
 				pelotas[j].setPos(pos2 + separacion);
+				pelotas[i].acotarAlMarco();
+				pelotas[j].acotarAlMarco();
 			}
 		}
 	}
 }
 
 
+//--------------------------------------------------------------
+// publicarContacto(punto, vel1, vel2)
+// Un choque entre dos pelotas. Como intercambian velocidades (masas
+// iguales), el impulso es el tamaño de la velocidad relativa.
+//--------------------------------------------------------------
+
+void ofApp::publicarContacto(ofVec2f punto, ofVec2f vel1, ofVec2f vel2)
+{
+	EventoSimulacion e;
+	e.tipo = SIM_CONTACTO;
+	e.x = punto.x;
+	e.y = punto.y;
+	e.valor = (vel1 - vel2).length();
+	eventos.publicar(e);
+}
+
+
+/*
+--------------------------------------------------------------
+ pasarPelotas(ahora)
+ Con partición: la pelota cuyo centro cruzó un borde abierto suelta
+ su nota (la que sigue sonando es asunto del vecino), se guarda con
+ la x relativa al borde y sale del pool. Su muerte agendada queda
+ vencida con el manejador.
+ Si se fueron todas, para esta franja es como si hubieran muerto:
+ empieza la dulce espera de la generación siguiente.
+--------------------------------------------------------------
+*/
+
+void ofApp::pasarPelotas(const Tick& ahora)
+{
+	int salieron = 0;
+	for (int i = pelotas.size() - 1; i >= 0; i--) {
+		Pelota& p = pelotas[i];
+		BordeParticion borde;
+		if (p.pos.x < marco.getLeft() && particion.abierto(BORDE_IZQUIERDO))
+			borde = BORDE_IZQUIERDO;
+		else if (p.pos.x > marco.getRight() && particion.abierto(BORDE_DERECHO))
+			borde = BORDE_DERECHO;
+		else
+			continue;
+
+		p.silenciar();
+		EstadoPelota e;
+		p.guardarEstado(e, ahora.numero);
+		float x = borde == BORDE_IZQUIERDO ? marco.getLeft() : marco.getRight();
+		e.pos[0] -= x;
+		e.posAnterior[0] -= x;
+		particion.enviar(e, borde, ahora);
+		pelotas.liberar(i);
+		salieron++;
+	}
+
+	if (salieron > 0 && pelotas.size() == 0 && !laNada) {
+		tiempoDefuncion = ahora.segundos;
+		laNada = true;
+		programarRegeneracion(ahora.numero);
+	}
+}
+
+
+/*
+--------------------------------------------------------------
+ recibirPelotas(ahora, factorVel)
+ Con partición: las pelotas que llegaron de un vecino entran por el
+ borde opuesto al que salieron. Se cargan como si hubieran vuelto a
+ nacer hace los ticks que duró el viaje (al ritmo activo del planificador,
+ el de los ticks con pelotas), así la vida que les queda es la misma,
+ y se adelantan lo que habrían recorrido en ese tiempo, sin salir de
+ la franja ni atravesar las paredes. Si la vida se les terminó en el
+ viaje, mueren en el próximo tick.
+ Con pelotas que llegan la arena ya no está vacía: la regeneración
+ agendada queda sin efecto, como si hubiera nacido una generación.
+ Si el pool está lleno, la pelota se cuenta como perdida.
+--------------------------------------------------------------
+*/
+
+void ofApp::recibirPelotas(const Tick& ahora, float factorVel)
+{
+	PelotaRecibida r;
+	while (particion.recibir(r)) {
+		ManejadorPelota manejador;
+		Pelota* p = pelotas.crear(&manejador);
+		if (p == nullptr) {                          // pool lleno: se pierde
+			particion.contarPerdida();
+			continue;
+		}
+
+		float x = r.entrada == BORDE_IZQUIERDO ? marco.getLeft() : marco.getRight();
+		r.estado.pos[0] += x;
+		r.estado.posAnterior[0] += x;
+		uint64_t viaje = min<uint64_t>((uint64_t)round(r.segundosViaje * planificador.getFpsActivo()), ahora.numero);
+		p->cargarEstado(r.estado, limitesPelotas, &eventos, ahora.segundos - r.segundosOrigen, ahora.numero - viaje);
+		p->pos += p->vel * (factorVel * viaje);
+		p->pos.x = ofClamp(p->pos.x, marco.getLeft(), marco.getRight()); // si le tocaba seguir, la pasa el próximo tick
+		p->acotarAlMarco();
+		p->posAnterior = p->pos;
+		p->setObstaculos(&obstaculos);
+		rueda.programar(max(p->tickMuerte(), ahora.numero + 1), { EVENTO_MUERTE, manejador });
+		
+		laNada = false;
+		regeneracionPendiente = false;
+	}
+}
+
+
 /*
 --------------------------------------------------------------
  keyPressed()
 
  Maneja ciertas acciones desde el teclado:
-  - Guardar o cargar presets
+  - Guardar o cargar presets, y llamar presets del banco con los números
   - Mostrar o ocultar GUI, en información útil en pantalla.
   - Crear o eliminar pelotas
+  - Simular en un hilo aparte o en el mismo hilo del dibujo
 --------------------------------------------------------------
  */
 
@@ -380,6 +1245,8 @@ void ofApp::detectarChoques()
 // El control de sliders, botones y parámetros propios de sonido y comportamiento está en la clase controlGUI
 
 void ofApp::keyPressed(int key) {
+	planificador.despertar();
+	sincronizarSimulacion();  // no tocar nada mientras corre un tick en el otro hilo
 	control.teclado(key);
 
 	switch(key) {
@@ -390,13 +1257,23 @@ void ofApp::keyPressed(int key) {
 			break;
 		}
 			
+		case 'h':
+			simulacionEnHilo = !simulacionEnHilo;
+			break;
+			
 		case 'i':
 			info = !info;
 			break;
 			
+		case 'u':
+			guardarPreset = true;
+			break;
+			
 		case 'n':
 		case 'N':
-			pelotas.clear();
+			for(int i = 0; i < pelotas.size(); i++)
+				pelotas[i].silenciar();   // los NoteOff salen con los eventos del próximo tick
+			pelotas.liberarTodas();
 			break;
 			
 		case 'x':{
@@ -408,20 +1285,92 @@ void ofApp::keyPressed(int key) {
 		case 'z':
 			showGUI = !showGUI;
 			break;
+			
+		case 'm':
+			obstaculos.cambiarModo();
+			break;
+			
+		case 'M':
+			obstaculos.borrarUltimo();
+			break;
+	}
+	
+	// Números: banco de presets ('1' es el lugar 0, ..., '0' el lugar 9)
+	if(key >= '0' && key <= '9') {
+		int lugar = (key == '0') ? 9 : key - '1';
+		if(guardarPreset)
+			banco.guardar(lugar, control);
+		else
+			banco.recuperar(lugar, control.morph);
+		guardarPreset = false;
 	}
 	
-	if(key == OF_KEY_SPACE) nacenPelotas();
+	if(key == OF_KEY_SPACE) {
+		Parametros par;              // estamos en el hilo del GUI: se pueden leer los sliders
+		control.capturar(par);
+		nacenPelotas(par);
+	}
 }
 
 // definimos la funcion del audio
 
 void ofApp::audioIn(float *input, int bufferSize, int nChannels) {
+	MEDIR_MEMORIA(ETAPA_AUDIO);
 	double v = 0;
 	for (int i=0; i<bufferSize; i++){
 		v += input[i] * input [i];
 	}
-	v - sqrt(v/bufferSize);
+	v = sqrt(v/bufferSize);   // nivel RMS
 	soundLevel = v;
+	planificador.nivelAudio(soundLevel);  // el sonido también saca del reposo
+}
+
+//--------------------------------------------------------------
+// audioOut()
+// Callback de salida: solo con el sintetizador interno (no bloquea)
+//--------------------------------------------------------------
+
+void ofApp::audioOut(float *output, int bufferSize, int nChannels) {
+	MEDIR_MEMORIA(ETAPA_AUDIO);
+	if(sintetizadorInterno) {
+		sintetizador.render(output, bufferSize, nChannels);
+		efectos.procesar(output, bufferSize, nChannels);
+	}
+	else
+		memset(output, 0, sizeof(float) * bufferSize * nChannels);
+}
+
+//--------------------------------------------------------------
+// Mouse: cualquier movimiento saca del reposo (el GUI tiene que responder)
+//--------------------------------------------------------------
+
+void ofApp::mouseMoved(int x, int y) {
+	planificador.despertar();
+}
+
+void ofApp::mouseDragged(int x, int y, int button) {
+	planificador.despertar();
+	capaInterfaz.marcarSucia();   // el panel se puede arrastrar de la cabecera
+	obstaculos.arrastrar(x, y);
+}
+
+void ofApp::mousePressed(int x, int y, int button) {
+	planificador.despertar();
+	capaInterfaz.marcarSucia();   // abrir/cerrar un grupo del panel no cambia ningún parámetro
+	
+	// Dibujo de obstáculos ('m'), salvo sobre el panel
+	if(obstaculos.getModo() != EDICION_NINGUNA && !(showGUI && gui.getShape().inside(x, y))) {
+		sincronizarSimulacion();  // cerrar un polígono cambia el campo de distancias
+		obstaculos.presionar(x, y, button);
+	}
+}
+
+void ofApp::mouseReleased(int x, int y, int button) {
+	planificador.despertar();
+	if(obstaculos.getModo() != EDICION_NINGUNA) {
+		sincronizarSimulacion();
+		obstaculos.soltar(x, y);
+	}
 }
 
 
@@ -438,8 +1387,19 @@ exit()
 
 void ofApp::exit()
 {
+	hilo.exit();                    // termina el último tick y detiene el hilo de simulación
+	if(intervaloPuntoControl > 0)
+		guardarPuntoControl(reloj.actual());  // el último estado, para retomar en el próximo arranque
+	puntoControl.cerrar();
+	descubridor.exit();             // deja de buscar puertos (puede estar abriendo alguno)
+	soundStream.close();
 	gui.saveToFile("Preset_de_cierre.xml"); // Guarda la configuración previa al cerrar el proyecto
 	ofLogNotice() << "Se cerró de forma correcta y se salvó el ultimo seteo GUI";
 	midi.allNotesOff(); ;          // Corta todas las notas, mando un Note Off para todas las notas que estén sonando
 	midi.exit();                    // Sale y cierra el puerto MIDI en uso
+	osc.exit();                     // Detiene el hilo OSC y libera el puerto
+	particion.exit();               // Deja de pasar pelotas a los vecinos
+	banco.exit();                   // Termina las escrituras de presets pendientes
+	relojMidi.cerrar();             // Deja de escuchar el reloj MIDI
+	Registro::detener();            // Escribe los mensajes que quedaban en el registro
 }
@@ -3,8 +3,32 @@
 #include "ofMain.h"
 #include "midiSender.h"
 #include "pelota.h"
+#include "poolPelotas.h"
 #include "ofxGui.h"
 #include "controlGui.h"
+#include "oscReceptor.h"
+#include "hiloSimulacion.h"
+#include "tripleBuffer.h"
+#include "instantanea.h"
+#include "bancoPresets.h"
+#include "reloj.h"
+#include "azar.h"
+#include "planificadorFrames.h"
+#include "capaInterfaz.h"
+#include "sintetizador.h"
+#include "cadenaEfectos.h"
+#include "puntoControl.h"
+#include "descubridorDispositivos.h"
+#include "cronometroArranque.h"
+#include "ruedaTemporizadores.h"
+#include "contadorMemoria.h"
+#include "obstaculos.h"
+#include "busEventos.h"
+#include "destellos.h"
+#include "estelas.h"
+#include "relojMidi.h"
+#include "particion.h"
+#include "controlCalidad.h"
 
 /*
 --------------------------------------------------------------
@@ -19,7 +43,9 @@
    - Draw de elementos visuales
    - Creación y actualización de pelotas
    - Sincronización con MIDI
+   - Recepción de parámetros por OSC
    - Detección de colisiones
+   - Simulación en un hilo aparte, con instantáneas para el dibujo
    - Manejo de GUI, teclado, ventanas y FBOs
  
 --------------------------------------------------------------
@@ -32,28 +58,88 @@ public:
 	void draw();
 	void exit();
 	
+	// Simulación
+	void simular();             // un tick de simulación completo
+	void publicarInstantanea(); // entrega a draw() lo que hay que dibujar
+	void sincronizarSimulacion(); // espera el tick en curso (antes de tocar estado desde un evento)
+	void guardarPuntoControl(const Tick& ahora); // copia el estado al archivo mapeado
+	bool retomarPuntoControl();   // vuelve al último estado guardado
+	
 	// Utilidades
 	void aplicarPixelado(float valor, bool usarLineal);
-	void nacenPelotas();        // generación de pelotas
-	void detectarChoques();     // detección de choques
+	void dibujarPelotas(float distorsion); // instantánea al FBO y a la pantalla, con pixelado
+	void dibujarInterfaz();     // GUI e info, desde su capa guardada
+	string textoMemoria();      // tiempo del frame y memoria pedida por etapa
+	void revisarPruebaMemoria(); // --test-alloc: falla si el frame pide memoria
+	void aplicarCalidad();       // lo que cambia con el nivel de ControlCalidad
+	void nacenPelotas(const Parametros& par); // generación de pelotas
+	void programarRegeneracion(uint64_t tick); // agenda el próximo nacimiento tras la dulce espera
+	void detectarChoques(float factorVel);  // detección de choques (barrida)
+	void publicarContacto(ofVec2f punto, ofVec2f vel1, ofVec2f vel2); // evento de choque al bus
+	void pasarPelotas(const Tick& ahora);   // partición: las que cruzaron un borde van al vecino
+	void recibirPelotas(const Tick& ahora, float factorVel); // partición: las que llegaron de un vecino
 	void windowResized(int w, int h);
 	
 	// audio
 	void audioIn(float *input, int bufferSize, int nChannels);
+	void audioOut(float *output, int bufferSize, int nChannels);
 	float soundLevel;
 	
 	void keyPressed(int key);
+	void mouseMoved(int x, int y);
+	void mouseDragged(int x, int y, int button);
+	void mousePressed(int x, int y, int button);
+	void mouseReleased(int x, int y, int button);
 	
 	// Variables generales
 	float tiempoDefuncion = 0;      // momento en que murió la última pelota
-	float dulceEspera = 2.0f;       // segundos a esperar antes del reseteo o nacimiento
+	float dulceEspera = 2.0f;       // segundos a esperar antes del reseteo o nacimiento (la que vale ahora)
+	float dulceEsperaLibre = 2.0f;  // sin reloj MIDI, en segundos
+	float esperaNegras = 4;         // con reloj MIDI, en negras
 	int NUM_PELOTAS;                // número de pelotas en el próximo nacimiento
+	int capacidadPelotas = 512;     // máximo de pelotas vivas a la vez (modo Sumar, --capacidad=N)
+	PoliticaPool politicaPool = POOL_RECHAZAR_NUEVAS; // qué hacer si se llena (--pool=...)
 
 	bool laNada = false;            // si false = hay pelotas vivas
 	bool showGUI;
 	bool info;
 	bool hacerNacer = false;
 	bool tiempoCumplido;            // ya pasó el tiempo de dulce espera, a nacer.
+	bool simulacionEnHilo = true;   // simula el tick siguiente mientras se dibuja el actual
+	bool guardarPreset = false;     // 'u': el próximo número guarda en vez de llamar
+	bool usarRelojVirtual = false;  // tiempo virtual (pruebas / render offline), se fija antes de setup()
+	float velocidadVirtual = 4;     // con reloj virtual: cuántas veces más rápido que el tiempo real
+	uint64_t semillaSesion = 0;     // semilla de todo el azar; 0 = se elige al arrancar
+	uint64_t numeroGeneracion = 0;  // generaciones nacidas, elige el flujo de azar de cada una
+	
+	// Salidas MIDI (main.cpp: --midi-salidas, --midi-efectos, --midi-ruteo)
+	vector<int> puertosMidi;          // puertos de las salidas de notas (vacío = puerto 0)
+	int puertoEfectosMidi = -1;       // puerto aparte para los CC, -1 = ninguno
+	ReglaRuteo ruteoMidi = RUTEO_ALTERNADO;
+	
+	bool sintetizadorInterno = false; // las notas suenan también en la salida de audio (--sinte)
+	
+	// Puntos de control (--punto-control=N, --sin-retomar)
+	float intervaloPuntoControl = 2;  // segundos entre guardados, 0 = no guardar
+	bool retomar = true;              // al arrancar, seguir desde el último punto de control
+	
+	string archivoObstaculos = "obstaculos.txt"; // en data/ (--obstaculos=ARCHIVO)
+	
+	// Reloj MIDI externo (--reloj-midi=PUERTO): nombre, o número de entrada
+	string entradaRelojMidi;
+	
+	// Partición de la arena entre procesos (--shard=i/n, --shard-puerto=P)
+	int indiceParticion = 0;          // franja de este proceso, desde 0
+	int totalParticiones = 1;         // 1 = un solo proceso, sin partición
+	int puertoParticion = 9100;       // el proceso i escucha en puertoParticion + i
+	
+	float presupuestoFrame = 1000.0f / 60.0f; // ms de update + draw (--presupuesto-frame=MS)
+	
+	// Prueba de memoria (--test-alloc[=N], requiere compilar con TF_CONTAR_MEMORIA)
+	int framesPruebaMemoria = 0;      // frames medidos, 0 = no hay prueba
+	int calentamientoMemoria = 600;   // frames antes de medir
+	
+	CronometroArranque arranque;      // fases del arranque (main.cpp lo inicia)
 
 	ofFbo fbo;
 	ofFbo fboPixelado;
@@ -67,8 +153,56 @@ public:
 	
 private:
 	
-	vector<Pelota> pelotas;         // vector que contiene todas las pelotas en pantalla
+	PoolPelotas pelotas;            // pool que contiene todas las pelotas en pantalla
 	MidiSender midi;                // módulo MIDI
+	OscReceptor osc;                // control remoto de parámetros por OSC
+	BancoPresets banco;             // presets precargados en memoria
+	
+	HiloSimulacion hilo;            // corre simular() en paralelo con draw()
+	TripleBuffer<Instantanea> instantaneas; // de simular() a draw(), sin bloqueo
+	vector<float> radiosGeneracion; // radios de la generación que nace (reservado en setup)
+	
+	PlanificadorFrames planificador; // baja los fps cuando no hay pelotas
+	CapaInterfaz capaInterfaz;       // GUI e info guardados en un FBO
+	Sintetizador sintetizador;       // voces internas, en el callback de audio
+	CadenaEfectos efectos;           // efectos del GUI sobre la salida del sintetizador
+	PuntoControl puntoControl;       // estado de la simulación en un archivo mapeado
+	DescubridorDispositivos descubridor; // busca y abre puertos MIDI y audio en segundo plano
+	ofSoundStream soundStream;
+	double ultimoPuntoControl = 0;
+	
+	Obstaculos obstaculos;           // obstáculos fijos y su campo de distancias
+	
+	Particion particion;             // franja de la arena y pase de pelotas a los vecinos
+	ofRectangle limitesPelotas;      // el marco, con los bordes entre franjas abiertos
+	ofVec2f mouseNacimiento;         // el mouse, leído en update(): ahí nacen sin Centro ni Acordes
+	
+	ControlCalidad calidad;          // baja lo visual si el frame se pasa del presupuesto
+	uint64_t microsUpdate = 0;       // lo que tardó el último update()
+	
+	BusEventos eventos;              // lo que pasó en el tick: de la física a MIDI, registro y visuales
+	RegistroEventos registroEventos; // suscriptor: diagnóstico por generación
+	Destellos destellos;             // suscriptor: anillos de rebotes y choques
+	Estelas estelas;                 // historia de posiciones y estelas de las pelotas
+	ofMesh mallaEstelas;             // todas las estelas del frame, en una sola tira
+	RuedaTemporizadores rueda;       // muertes y regeneración agendadas por tick
+	vector<EventoRueda> vencidos;    // eventos que vencen en el tick (reservado en setup)
+	bool regeneracionPendiente = false; // venció la espera con la regeneración apagada
+	
+	RelojMidi relojMidi;             // tempo y posición de un reloj MIDI externo
+	EstadoRelojMidi tempoMidi;       // leído una vez por frame, para la simulación
+	double negrasAnterior = 0;       // posición del tick anterior (para ver si empezó una negra)
+	uint32_t iniciosMidi = 0;        // Start ya atendidos
+	bool nacerEnInicio = false;      // llegó un Start: nace una generación apenas enganche
+	
+	int framePruebaMemoria = 0;      // --test-alloc: frames transcurridos
+	int framesConPedidos = 0;
+	int primerFrameConPedidos = 0;
+	ConteoMemoria pedidosPrueba;     // lo que se pidió en los frames medidos
+	
+	Reloj reloj;                    // hora del tick, muestreada una vez por tick
+	RelojReal relojReal;
+	RelojVirtual relojVirtual;
 	
 	
 };
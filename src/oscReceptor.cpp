@@ -0,0 +1,158 @@
+/*
+--------------------------------------------------------------
+ oscReceptor.cpp
+
+ Implementación de la clase OscReceptor
+ 
+ El hilo de recepción solo hace tres cosas por mensaje:
+ hashear la dirección, buscarla en la tabla y guardar el valor
+ en la casilla atómica del parámetro. Todo lo que toca al GUI
+ sucede después, en aplicar(), desde el hilo de update.
+--------------------------------------------------------------
+*/
+
+#include "oscReceptor.h"
+
+static_assert(NUM_PARAMETROS <= 32, "los parámetros pendientes se guardan en una máscara de 32 bits");
+
+/*
+--------------------------------------------------------------
+ setup(puerto)
+ - Arma la tabla de direcciones
+ - Abre el receptor UDP en el puerto dado
+ - Arranca el hilo
+--------------------------------------------------------------
+*/
+
+void OscReceptor::setup(int puerto)
+{
+	for(int i = 0; i < NUM_PARAMETROS; i++)
+		valores[i].store(0);
+	
+	armarTabla();
+	receptor.setup(puerto);
+	startThread();
+	
+	ofLogNotice() << "OSC escuchando en el puerto " << puerto;
+}
+
+//--------------------------------------------------------------
+// hashDireccion()
+//  FNV-1a de 32 bits. Se usa igual para armar la tabla y para
+//  buscar, así que solo importa que sea rápido y estable.
+//--------------------------------------------------------------
+
+uint32_t OscReceptor::hashDireccion(const string& direccion)
+{
+	uint32_t h = 2166136261u;
+	for(unsigned char c : direccion) {
+		h ^= c;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+//--------------------------------------------------------------
+// armarTabla()
+//  Direccionamiento abierto con sondeo lineal. La tabla tiene
+//  casi cuatro veces más casillas que parámetros (ocupación
+//  menor al 30 %), así que las búsquedas terminan casi siempre
+//  en la primera casilla.
+//--------------------------------------------------------------
+
+void OscReceptor::armarTabla()
+{
+	for(int id = 0; id < NUM_PARAMETROS; id++) {
+		string direccion = string("/tf/") + Controles::nombreParametro(id);
+		uint32_t h = hashDireccion(direccion);
+		
+		int i = h & (TAM_TABLA - 1);
+		while(tabla[i].id != -1)
+			i = (i + 1) & (TAM_TABLA - 1);
+		
+		tabla[i].hash = h;
+		tabla[i].id = id;
+		tabla[i].direccion = direccion;
+	}
+}
+
+int OscReceptor::buscar(const string& direccion)
+{
+	uint32_t h = hashDireccion(direccion);
+	int i = h & (TAM_TABLA - 1);
+	
+	while(tabla[i].id != -1) {
+		// el string se compara solo si el hash coincide
+		if(tabla[i].hash == h && tabla[i].direccion == direccion)
+			return tabla[i].id;
+		i = (i + 1) & (TAM_TABLA - 1);
+	}
+	return -1;
+}
+
+/*
+--------------------------------------------------------------
+ threadedFunction()
+ Vacía la cola del receptor y deja cada valor en su casilla.
+ Acepta argumentos float, int o booleanos.
+--------------------------------------------------------------
+*/
+
+void OscReceptor::threadedFunction()
+{
+	ofxOscMessage m;
+	
+	while(isThreadRunning()) {
+		while(receptor.getNextMessage(m)) {
+			recibidos++;
+			
+			int id = buscar(m.getAddress());
+			if(id < 0 || m.getNumArgs() == 0) {
+				desconocidos++;
+				continue;
+			}
+			
+			float valor;
+			switch(m.getArgType(0)) {
+				case OFXOSC_TYPE_FLOAT: valor = m.getArgAsFloat(0); break;
+				case OFXOSC_TYPE_INT32: valor = m.getArgAsInt32(0); break;
+				case OFXOSC_TYPE_TRUE:  valor = 1; break;
+				case OFXOSC_TYPE_FALSE: valor = 0; break;
+				default: desconocidos++; continue;
+			}
+			
+			// Primero el valor, después el bit: quien ve el bit ve el valor
+			valores[id].store(valor, std::memory_order_relaxed);
+			uint32_t bit = 1u << id;
+			if(pendientes.fetch_or(bit, std::memory_order_release) & bit)
+				coalescidos++;   // pisó un valor que todavía no se había aplicado
+		}
+		sleep(1);
+	}
+}
+
+/*
+--------------------------------------------------------------
+ aplicar(control)
+ Se llama una vez por frame desde update(). Toma todos los
+ bits pendientes de una sola vez y escribe cada valor en su slider.
+--------------------------------------------------------------
+*/
+
+void OscReceptor::aplicar(Controles& control)
+{
+	uint32_t mascara = pendientes.exchange(0, std::memory_order_acquire);
+	
+	while(mascara) {
+		int id = __builtin_ctz(mascara);
+		mascara &= mascara - 1;
+		control.setParametro(id, valores[id].load(std::memory_order_relaxed));
+	}
+}
+
+// Detiene el hilo y libera el puerto
+void OscReceptor::exit()
+{
+	waitForThread(true);
+	receptor.stop();
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxOsc.h"
+#include "controlGui.h"
+
+/*
+--------------------------------------------------------------
+ oscReceptor.h
+
+ Clase OscReceptor
+
+ Recibe mensajes OSC en un hilo propio y los convierte en
+ cambios de los parámetros de Controles:
+
+   - Cada dirección "/tf/<nombre>" corresponde a un parámetro
+     (ej: /tf/factorVel 1.5, /tf/sumar 1). El valor va en las
+     mismas unidades que el slider del GUI.
+   - Las direcciones se buscan en una tabla hasheada de antemano,
+     así cada mensaje cuesta una búsqueda O(1).
+   - Los valores no se escriben en el GUI desde este hilo: se dejan
+     en una "casilla" atómica por parámetro y el hilo de update los
+     aplica con aplicar(). Si llegan muchos mensajes del mismo
+     parámetro entre dos frames, solo queda el último (coalescencia).
+
+ No hay mutex entre el hilo OSC y el de update/GUI, así que un
+ controlador que manda cientos de mensajes por segundo no frena
+ el dibujo.
+--------------------------------------------------------------
+*/
+
+class OscReceptor : public ofThread
+{
+public:
+	// Abre el puerto UDP y arranca el hilo de recepción
+	void setup(int puerto = 9000);
+	
+	// Aplica los valores pendientes sobre los controles (hilo de update)
+	void aplicar(Controles& control);
+	
+	// Detiene el hilo y cierra el puerto
+	void exit();
+	
+	// Contadores para diagnóstico
+	uint32_t getRecibidos()    { return recibidos.load(); }
+	uint32_t getCoalescidos()  { return coalescidos.load(); }
+	uint32_t getDesconocidos() { return desconocidos.load(); }
+	
+private:
+	void threadedFunction();
+	
+	// Tabla de despacho: dirección OSC -> ParametroId
+	void armarTabla();
+	int buscar(const string& direccion);
+	static uint32_t hashDireccion(const string& direccion);
+	
+	static const int TAM_TABLA = 64;   // potencia de 2, mayor que NUM_PARAMETROS
+	struct Entrada {
+		uint32_t hash = 0;
+		int id = -1;                   // -1 = casilla vacía
+		string direccion;
+	};
+	Entrada tabla[TAM_TABLA];
+	
+	// Casillas de valores pendientes, una por parámetro
+	std::atomic<float> valores[NUM_PARAMETROS];
+	std::atomic<uint32_t> pendientes{0};  // un bit por parámetro con valor nuevo
+	
+	std::atomic<uint32_t> recibidos{0};
+	std::atomic<uint32_t> coalescidos{0};
+	std::atomic<uint32_t> desconocidos{0};
+	
+	ofxOscReceiver receptor;
+};
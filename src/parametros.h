@@ -0,0 +1,54 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ parametros.h
+
+ Estructura Parametros
+
+ Copia "plana" (solo números) de todos los parámetros del GUI,
+ tomada una vez por frame en el hilo del GUI y publicada para los
+ hilos de trabajo (simulación, MIDI) con un TripleBuffer.
+ Así nadie fuera del hilo del GUI lee los ofxSlider / ofxToggle.
+
+   - valores[id]  valor de cada ParametroId, en unidades del slider
+   - cambios      un bit por parámetro: cambió desde la última
+                  copia que leyó el consumidor
+   - version      aumenta con cada publicación
+--------------------------------------------------------------
+*/
+
+// Identificadores de los parámetros controlables desde afuera del GUI.
+// El orden no importa, pero no deben pasar de 32 (se usan como bits).
+enum ParametroId {
+	PARAM_RANGO_RANDOM = 0,
+	PARAM_TIPO_ESCALA,
+	PARAM_FACTOR_VITAL,
+	PARAM_FACTOR_VEL,
+	PARAM_RANDOM,
+	PARAM_REGENERACION,
+	PARAM_SUMAR,
+	PARAM_CENTRO,
+	PARAM_ACORDES,
+	PARAM_ATAQUE,
+	PARAM_RELEASE,
+	PARAM_DISTORSION,
+	PARAM_FILTRO,
+	PARAM_DELAY,
+	PARAM_TIEMPO,
+	PARAM_FEEDBACK,
+	PARAM_REVERB,
+	NUM_PARAMETROS
+};
+
+struct Parametros {
+	float valores[NUM_PARAMETROS] = {0};
+	uint32_t cambios = 0;
+	uint64_t version = 0;
+	
+	float get(int id) const { return valores[id]; }
+	int getInt(int id) const { return (int)valores[id]; }
+	bool activo(int id) const { return valores[id] >= 0.5f; }
+	bool cambio(int id) const { return cambios & (1u << id); }
+};
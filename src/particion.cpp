@@ -0,0 +1,229 @@
+/*
+--------------------------------------------------------------
+ particion.cpp
+
+ Implementación de la clase Particion
+--------------------------------------------------------------
+*/
+
+#include "particion.h"
+#include "registro.h"
+
+static const char* DIRECCION_PELOTA = "/tf/particion/pelota";
+static const float LEJOS = 1e7f;   // hasta donde se corre un borde abierto
+
+void Particion::setup(int i, int n, int puertoBase, const string& host)
+{
+	indice = i;
+	total = max(1, n);
+	if(!activa()) return;
+
+	receptor.setup(puertoBase + indice);
+	if(abierto(BORDE_IZQUIERDO))
+		vecinos[BORDE_IZQUIERDO].setup(host, puertoBase + indice - 1);
+	if(abierto(BORDE_DERECHO))
+		vecinos[BORDE_DERECHO].setup(host, puertoBase + indice + 1);
+	sesion = ofGetSystemTimeMicros();
+	startThread();
+
+	ofLogNotice() << "Partición " << indice + 1 << " de " << total
+				  << ": escucha en el puerto " << puertoBase + indice;
+}
+
+ofRectangle Particion::limites(const ofRectangle& marco)
+{
+	float izquierda = abierto(BORDE_IZQUIERDO) ? marco.getLeft() - LEJOS : marco.getLeft();
+	float derecha = abierto(BORDE_DERECHO) ? marco.getRight() + LEJOS : marco.getRight();
+	return ofRectangle(izquierda, marco.getTop(), derecha - izquierda, marco.getHeight());
+}
+
+// Hilo de la simulación: solo copia a la cola
+bool Particion::enviar(const EstadoPelota& estado, BordeParticion borde, const Tick& ahora)
+{
+	uint32_t f = finSalida.load(std::memory_order_relaxed);
+	if(f - cabezaSalida.load(std::memory_order_acquire) >= CAPACIDAD) {
+		perdidas++;
+		return false;
+	}
+	colaSalida[f & (CAPACIDAD - 1)] = { estado, borde, ahora.numero, ahora.segundos, ofGetSystemTimeMicros() };
+	finSalida.store(f + 1, std::memory_order_release);
+	return true;
+}
+
+bool Particion::recibir(PelotaRecibida& pelota)
+{
+	uint32_t c = cabezaEntrada.load(std::memory_order_relaxed);
+	if(c == finEntrada.load(std::memory_order_acquire)) return false;
+	pelota = colaEntrada[c & (CAPACIDAD - 1)];
+	cabezaEntrada.store(c + 1, std::memory_order_release);
+	return true;
+}
+
+void Particion::exit()
+{
+	if(!activa()) return;
+	waitForThread(true);
+	receptor.stop();
+}
+
+void Particion::threadedFunction()
+{
+	while(isThreadRunning()) {
+		mandarCola();
+		leerRed();
+		sleep(1);
+	}
+}
+
+/*
+--------------------------------------------------------------
+ mandarCola()
+ Un mensaje por pelota:
+   origen (int32), sesión, secuencia, tick, hora de la simulación
+   y hora del sistema en µs (int64), y el EstadoPelota como blob.
+ La sesión cambia cada vez que arranca el proceso: si un vecino se
+ reinicia, su secuencia vuelve a empezar sin que se la descarte.
+--------------------------------------------------------------
+*/
+
+void Particion::mandarCola()
+{
+	ofxOscMessage m;
+	uint32_t c = cabezaSalida.load(std::memory_order_relaxed);
+	uint32_t f = finSalida.load(std::memory_order_acquire);
+
+	for(; c != f; c++) {
+		const Salida& s = colaSalida[c & (CAPACIDAD - 1)];
+		m.clear();
+		m.setAddress(DIRECCION_PELOTA);
+		m.addIntArg(indice);
+		m.addInt64Arg((int64_t)sesion);
+		m.addInt64Arg((int64_t)++secuenciaSalida[s.borde]);
+		m.addInt64Arg((int64_t)s.tick);
+		m.addInt64Arg((int64_t)(s.segundos * 1000000.0));
+		m.addInt64Arg((int64_t)s.micros);
+		m.addBlobArg(ofBuffer((const char*)&s.estado, sizeof(EstadoPelota)));
+		vecinos[s.borde].sendMessage(m, false);
+		enviadas++;
+	}
+	cabezaSalida.store(c, std::memory_order_release);
+}
+
+/*
+--------------------------------------------------------------
+ leerRed()
+ Acepta solo mensajes de los vecinos inmediatos. Por cada borde
+ recuerda la sesión y la última secuencia: lo que no es posterior
+ se descarta (UDP puede repetir o desordenar), y un salto cuenta
+ las que se perdieron en el camino.
+--------------------------------------------------------------
+*/
+
+void Particion::leerRed()
+{
+	ofxOscMessage m;
+	while(receptor.getNextMessage(m)) {
+		if(m.getAddress() != DIRECCION_PELOTA || m.getNumArgs() != 7 ||
+		   m.getArgType(6) != OFXOSC_TYPE_BLOB)
+			continue;
+
+		int origen = m.getArgAsInt32(0);
+		BordeParticion entrada;
+		if(origen == indice - 1)      entrada = BORDE_IZQUIERDO;
+		else if(origen == indice + 1) entrada = BORDE_DERECHO;
+		else continue;
+
+		uint64_t sesionVecino = (uint64_t)m.getArgAsInt64(1);
+		uint64_t secuencia = (uint64_t)m.getArgAsInt64(2);
+		if(sesionVecino != sesionEntrada[entrada]) {
+			sesionEntrada[entrada] = sesionVecino;
+			secuenciaEntrada[entrada] = 0;
+		}
+		if(secuencia <= secuenciaEntrada[entrada]) {
+			desordenadas++;
+			continue;
+		}
+		if(secuencia > secuenciaEntrada[entrada] + 1) {
+			perdidas += secuencia - secuenciaEntrada[entrada] - 1;
+			REGISTRO_WARNING("Partición: se perdieron {} pelotas del vecino {} (tick {})",
+							 secuencia - secuenciaEntrada[entrada] - 1, origen + 1, m.getArgAsInt64(3));
+		}
+		secuenciaEntrada[entrada] = secuencia;
+
+		ofBuffer blob = m.getArgAsBlob(6);
+		if(blob.size() != sizeof(EstadoPelota)) continue;
+
+		uint32_t f = finEntrada.load(std::memory_order_relaxed);
+		if(f - cabezaEntrada.load(std::memory_order_acquire) >= CAPACIDAD) {
+			perdidas++;
+			continue;
+		}
+		PelotaRecibida& r = colaEntrada[f & (CAPACIDAD - 1)];
+		memcpy(&r.estado, blob.getData(), sizeof(EstadoPelota));
+		r.entrada = entrada;
+		r.segundosOrigen = m.getArgAsInt64(4) / 1000000.0;
+		double viaje = (int64_t)(ofGetSystemTimeMicros() - (uint64_t)m.getArgAsInt64(5)) / 1000000.0;
+		r.segundosViaje = max(0.0, min(viaje, MAX_SEGUNDOS_VIAJE));
+		finEntrada.store(f + 1, std::memory_order_release);
+		recibidas++;
+	}
+}
+
+
+/*
+--------------------------------------------------------------
+ prueba(puertoBase)
+ Las franjas 1 y 2 de 2, en el mismo proceso y por UDP de verdad:
+ la 1 le pasa 200 pelotas a la 2 por su borde derecho y la 2 le
+ devuelve 50 por el izquierdo. Cada pelota lleva su número en la y
+ para ver el orden.
+--------------------------------------------------------------
+*/
+
+bool Particion::prueba(int puertoBase)
+{
+	Particion a, b;
+	a.setup(0, 2, puertoBase);
+	b.setup(1, 2, puertoBase);
+
+	Tick t;
+	t.numero = 100;
+	t.segundos = 10;
+
+	auto pasar = [&t](Particion& origen, Particion& destino, BordeParticion borde, int cantidad) {
+		for(int i = 0; i < cantidad; i++) {
+			EstadoPelota e = {};
+			e.pos[0] = borde == BORDE_DERECHO ? 5 : -5;
+			e.pos[1] = i;
+			origen.enviar(e, borde, t);
+		}
+
+		int llegadas = 0;
+		double viajeMaximo = 0;
+		bool enOrden = true;
+		uint64_t limite = ofGetElapsedTimeMillis() + 2000;
+		PelotaRecibida r;
+		while(llegadas < cantidad && ofGetElapsedTimeMillis() < limite) {
+			if(!destino.recibir(r)) {
+				ofSleepMillis(1);
+				continue;
+			}
+			if(r.estado.pos[1] != llegadas || r.entrada == borde) enOrden = false;
+			viajeMaximo = max(viajeMaximo, r.segundosViaje);
+			llegadas++;
+		}
+		ofLogNotice("Particion") << "franja " << origen.getIndice() + 1 << " -> " << destino.getIndice() + 1 << ": "
+								 << llegadas << " de " << cantidad << ", " << (enOrden ? "en orden" : "DESORDENADAS")
+								 << ", viaje máximo " << ofToString(viajeMaximo * 1000, 2) << " ms";
+		return llegadas == cantidad && enOrden;
+	};
+
+	bool bien = pasar(a, b, BORDE_DERECHO, 200);
+	bien = pasar(b, a, BORDE_IZQUIERDO, 50) && bien;
+	bien = bien && a.getPerdidas() + b.getPerdidas() == 0 && a.getDesordenadas() + b.getDesordenadas() == 0;
+
+	a.exit();
+	b.exit();
+	ofLogNotice("Particion") << (bien ? "bien" : "FALLA");
+	return bien;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxOsc.h"
+#include "estadoGuardado.h"
+#include "reloj.h"
+#include <atomic>
+
+/*
+--------------------------------------------------------------
+ particion.h
+
+ Clase Particion
+
+ Reparte la arena entre varios procesos de Terrorizer, uno al lado
+ del otro (por ejemplo, uno por proyector): el proceso i de n tiene
+ la franja i, contando de izquierda a derecha, y cada uno simula,
+ dibuja y manda MIDI de las pelotas que están en la suya.
+
+   - Los bordes entre franjas están abiertos: la pelota no rebota
+     ahí (ver limites()). Cuando su centro cruza el borde, ofApp la
+     saca del pool y la entrega con enviar() al proceso vecino.
+   - Cada pelota viaja en un mensaje OSC por UDP, con el mismo
+     EstadoPelota del punto de control, el número de secuencia del
+     enlace, el tick y la hora del que la manda. El receptor descarta
+     lo repetido o atrasado y cuenta lo perdido (huecos en la secuencia).
+   - Alineación: las pelotas que llegan se agregan al comienzo de un
+     tick, nunca en medio, y se adelantan el tiempo que tardaron en
+     llegar (por la hora del sistema, común a los procesos de una
+     máquina; ofApp lo pasa a ticks con su ritmo), así siguen con la
+     vida y el camino que tenían.
+
+ enviar() y recibir() no bloquean: el hilo de la partición manda y
+ recibe por la red, y se comunica con la simulación por dos colas
+ de un productor y un consumidor.
+
+ El proceso i escucha en puertoBase + i.
+--------------------------------------------------------------
+*/
+
+enum BordeParticion : uint8_t {
+	BORDE_IZQUIERDO,
+	BORDE_DERECHO
+};
+
+// Una pelota que llegó de un vecino, lista para entrar a la simulación
+struct PelotaRecibida {
+	EstadoPelota estado;      // x relativa al borde por el que entra
+	BordeParticion entrada;   // borde propio por el que entra
+	double segundosViaje = 0; // lo que pasó desde que salió (hora del sistema)
+	double segundosOrigen = 0; // hora de la simulación del que la mandó
+};
+
+class Particion : public ofThread
+{
+public:
+	static constexpr double MAX_SEGUNDOS_VIAJE = 0.5;   // más que esto no se adelanta (relojes desparejos)
+
+	// Proceso "indice" de "total". Con total = 1 no abre nada.
+	void setup(int indice, int total, int puertoBase, const string& host = "127.0.0.1");
+
+	bool activa() { return total > 1; }
+	bool abierto(BordeParticion borde) { return borde == BORDE_IZQUIERDO ? indice > 0 : indice < total - 1; }
+	int getIndice() { return indice; }
+	int getTotal() { return total; }
+
+	// Límites para las pelotas: el marco con los bordes abiertos corridos bien lejos
+	ofRectangle limites(const ofRectangle& marco);
+
+	// Entrega una pelota al vecino de ese borde (hilo de la simulación, no bloquea).
+	// La x del estado va relativa al borde. Devuelve false si la cola está llena.
+	bool enviar(const EstadoPelota& estado, BordeParticion borde, const Tick& ahora);
+
+	// La próxima pelota que llegó, si hay (hilo de la simulación)
+	bool recibir(PelotaRecibida& pelota);
+
+	// Detiene el hilo
+	void exit();
+
+	// --test-shard: dos particiones en este proceso, por localhost. true si
+	// las pelotas llegan todas, en orden y por el borde que corresponde.
+	static bool prueba(int puertoBase);
+
+	// Una pelota recibida que no entró en la simulación (pool lleno)
+	void contarPerdida() { perdidas++; }
+	
+	// Contadores para la info en pantalla
+	uint64_t getEnviadas()     { return enviadas.load(); }
+	uint64_t getRecibidas()    { return recibidas.load(); }
+	uint64_t getPerdidas()     { return perdidas.load(); }     // huecos en la secuencia, o colas llenas
+	uint64_t getDesordenadas() { return desordenadas.load(); } // repetidas o atrasadas, descartadas
+
+private:
+	void threadedFunction();
+	void mandarCola();
+	void leerRed();
+
+	struct Salida {
+		EstadoPelota estado;
+		BordeParticion borde;
+		uint64_t tick;
+		double segundos;
+		uint64_t micros;       // hora del sistema al salir
+	};
+
+	static const uint32_t CAPACIDAD = 256;   // potencia de 2
+
+	// De la simulación al hilo
+	Salida colaSalida[CAPACIDAD];
+	std::atomic<uint32_t> cabezaSalida{0}, finSalida{0};
+
+	// Del hilo a la simulación
+	PelotaRecibida colaEntrada[CAPACIDAD];
+	std::atomic<uint32_t> cabezaEntrada{0}, finEntrada{0};
+
+	int indice = 0;
+	int total = 1;
+	ofxOscReceiver receptor;
+	ofxOscSender vecinos[2];         // por borde
+	uint64_t sesion = 0;             // hora de arranque: distingue un vecino reiniciado
+	uint64_t secuenciaSalida[2] = {0, 0};
+	uint64_t sesionEntrada[2] = {0, 0};
+	uint64_t secuenciaEntrada[2] = {0, 0}; // la última recibida por cada borde
+
+	std::atomic<uint64_t> enviadas{0}, recibidas{0}, perdidas{0}, desordenadas{0};
+};
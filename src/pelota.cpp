@@ -8,11 +8,13 @@
    - velocidad y radio individuales.
    - un tiempo de vida (tiempoVital)
    - Límite espacial (limites)
-   - Comunicación MIDI al chocar contra paredes
+   - Eventos (notas, rebotes) al chocar contra paredes
 
  Las pelotas viven, chocan y rebotan dentro del rectangulo establecido por límites,
  emitiendo notas MIDI al "rebotar" contra las paredes del rectangulo.
  También pueden emitir otros mensajes.
+ No mandan nada directamente: publican eventos en el BusEventos, y el MIDI
+ (y quien más esté suscripto) los recibe al final del tick.
  Mueren según un tiempo predefinido y común para todas las pelotas de una misma generación.
  La vida de las pelotas termina cuando se van las bolas se van volviendo transparentes hasta desaparecer
  luego puede venir una nueva generación de pelotas o no,
@@ -22,6 +24,7 @@
 */
 
 #include "pelota.h"
+#include "colisiones.h"
 
 
 /*
@@ -41,42 +44,47 @@
 
 void Pelota::setup() {
 	pos.set(ofGetWidth()/2, ofGetHeight()/2);
-	vel.set(ofRandom(-15, 15), ofRandom(-15, 15));
-	radio = ofRandom(10,30);
+	vel.set(azar.uniforme(-15, 15), azar.uniforme(-15, 15));
+	radio = azar.uniforme(10,30);
 	
 	limites = ofRectangle(0, 0, ofGetWidth(), ofGetHeight());
 	
-	midi = nullptr;      // Asigna el apuntador midi a un puntero nulo para que no genere problemas
+	eventos = nullptr;   // Sin bus la pelota no se actualiza, para que no genere problemas
 	tiempoVital = 1000;  // Inicializa el tiempo de vida de las pelotas
 }
 
 /*
 --------------------------------------------------------------
- setup(marco, midiSender, nota, radioParam, vida)
+ setup(marco, bus, nota, radioParam, vida, semilla)
 
  Es la anterior función setup pero sobrecargada.
  inicializa una pelota con los siguientes argumentos:
 
    marco         - rectángulo donde vive cada pelota, todas viven en un mismo espacio.
-   midiSender    - canal MIDI para enviar notas, es el mismo para todas las pelotas.
+   bus           - bus de eventos donde publica notas y rebotes, es el mismo para todas las pelotas.
    nota          - nota MIDI asignada por pelota, el rango es de unas cinco octavas, entre 24 y 96.
    radioParam    - tamaño de la pelota. El radio y la nota son inversamente proporcionales
    vida          - tiempo de vida en milisegundos
+   semilla       - semilla del generador de la pelota; la misma semilla da la misma velocidad
+                   y los mismos renacimientos
  
    Seteo de variables internas de estado.
  --------------------------------------------------------------
  */
 
 
-void Pelota::setup(ofRectangle marco, MidiSender* midiSender, int midiNote, float radioParam, int vida)
+void Pelota::setup(ofRectangle marco, BusEventos* bus, int midiNote, float radioParam, int vida, uint64_t semilla)
 {
+	azar.sembrar(semilla);
 	limites = marco;
 	radio = radioParam;
 	pos.set(marco.getCenter());
-	vel.set(ofRandom(-15, 15), ofRandom(-15, 15));
+	posAnterior = pos;
+	vel.set(azar.uniforme(-15, 15), azar.uniforme(-15, 15));
 	
-	midi = midiSender;
+	eventos = bus;
 	note = midiNote;
+	salida = 0;
 	tiempoVital = vida;
 	
 	esperandoNacer = false;  // La pelota sigue viva. Si fuera true la pelota murió.
@@ -101,9 +109,10 @@ reset()
 
 void Pelota::reset(ofRectangle marco) {
 	
-	radio = ofRandom(10,50);                     // Radio aleatorio al renacer
+	radio = azar.uniforme(10,50);                // Radio aleatorio al renacer
 	pos.set(ofGetMouseX(), ofGetMouseY());       // Renace donde está el mouse
-	vel.set(ofRandom(-15,15), ofRandom(-15,15));
+	posAnterior = pos;
+	vel.set(azar.uniforme(-15,15), azar.uniforme(-15,15));
 	tiempoVital = 1000;                          // Tiempo de vida de la pelota
 	esperandoNacer = false;
 	noteOn = false;
@@ -114,6 +123,106 @@ void Pelota::reset(ofRectangle marco) {
 	
 }
 
+//--------------------------------------------------------------
+// guardarEstado() / cargarEstado()
+// Todo lo que hace falta para que la pelota siga exactamente igual
+// después de reiniciar la aplicación (ver PuntoControl).
+//--------------------------------------------------------------
+
+void Pelota::guardarEstado(EstadoPelota& e, uint64_t tick) {
+	e.pos[0] = pos.x;                 e.pos[1] = pos.y;
+	e.vel[0] = vel.x;                 e.vel[1] = vel.y;
+	e.posAnterior[0] = posAnterior.x; e.posAnterior[1] = posAnterior.y;
+	e.radio = radio;
+	e.tiempoVital = vidaRestante(tick);
+	e.tiempoDefuncion = tiempoDefuncion;
+	e.dulceEspera = dulceEspera;
+	e.nota = note;
+	e.salida = salida;
+	e.ccOpenTime = ccOpenTime_1;
+	azar.getEstado(e.azar);
+	e.esperandoNacer = esperandoNacer;
+	e.noteOn = noteOn;
+	e.relleno[0] = e.relleno[1] = 0;
+}
+
+void Pelota::cargarEstado(const EstadoPelota& e, ofRectangle marco, BusEventos* bus, double desplazamiento, uint64_t tick) {
+	limites = marco;
+	eventos = bus;
+	pos.set(e.pos[0], e.pos[1]);
+	vel.set(e.vel[0], e.vel[1]);
+	posAnterior.set(e.posAnterior[0], e.posAnterior[1]);
+	radio = e.radio;
+	tiempoVital = e.tiempoVital;
+	tickNacimiento = tick;
+	tiempoDefuncion = e.tiempoDefuncion + desplazamiento;
+	dulceEspera = e.dulceEspera;
+	note = e.nota;
+	salida = e.salida;
+	ccOpenTime_1 = e.ccOpenTime + (int)(desplazamiento * 1000);
+	azar.setEstado(e.azar);
+	esperandoNacer = e.esperandoNacer;
+	noteOn = e.noteOn;
+}
+
+//--------------------------------------------------------------
+// silenciar()
+// Publica el Note Off si la pelota tiene la nota sonando.
+// Se usa cuando una pelota viva se saca del pool sin morir.
+//--------------------------------------------------------------
+
+void Pelota::silenciar() {
+	if(eventos == nullptr) return;
+	if(noteOn) {
+		publicar(SIM_NOTA_OFF, note);
+		noteOn = false;
+	}
+	if(notaObstaculo >= 0) {
+		publicar(SIM_NOTA_OFF, notaObstaculo);
+		notaObstaculo = -1;
+	}
+}
+
+//--------------------------------------------------------------
+// publicar(tipo, nota)
+//--------------------------------------------------------------
+
+void Pelota::publicar(TipoEventoSimulacion tipo, int nota) {
+	EventoSimulacion e;
+	e.tipo = tipo;
+	e.nota = nota;
+	e.salida = salida;
+	e.x = pos.x;
+	e.y = pos.y;
+	eventos->publicar(e);
+}
+
+//--------------------------------------------------------------
+// tickMuerte()
+// Primer tick en el que la pelota ya no tiene vida: el que sigue al
+// update que la dejó en cero o menos. Es el mismo tick en el que antes
+// la descubría muerta la cuenta regresiva de update().
+//--------------------------------------------------------------
+
+uint64_t Pelota::tickMuerte() {
+	if (tiempoVital <= 0) return tickNacimiento + 1;
+	return tickNacimiento + (uint64_t)ceil(tiempoVital / 2.0f) + 1;
+}
+
+//--------------------------------------------------------------
+// morir(tick)
+// La llama ofApp cuando vence la muerte agendada en la rueda.
+// Empieza la cuenta desde que murió, suelta la nota y avisa.
+//--------------------------------------------------------------
+
+void Pelota::morir(const Tick& tick) {
+	esperandoNacer = true;
+	tiempoDefuncion = tick.segundos;
+	silenciar();
+	if(eventos != nullptr)
+		publicar(SIM_MUERTE, note);
+}
+
 //--------------------------------------------------------------
 // isDead()
 // Devuelve true si la pelota terminó su ciclo de vida y está
@@ -127,55 +236,121 @@ bool Pelota::isDead(){
 
 /*
  --------------------------------------------------------------
- update(factorVel)
+ update(factorVel, tick)
  
  Actualiza la física:
-   - Movimiento
-   - Cuenta regresiva del tiempo de vida
-   - Rebotes contra paredes
-   - Envío de mensaje MIDI NoteOn / NoteOff
-   - Manejo de muerte / renacimiento
+   - Movimiento, en sub-pasos si la pelota es rápida
+   - Rebotes contra paredes y obstáculos
+   - Publicación de NoteOn / NoteOff y de los rebotes (sin I/O)
+ La hora sale de "tick" (muestreada una vez por tick en ofApp),
+ nunca del reloj del sistema.
+ La muerte ya no se revisa acá: queda agendada al nacer (tickMuerte)
+ y ofApp llama a morir() cuando vence.
  --------------------------------------------------------------
  */
 
-void Pelota::update(float factorVel) {
+void Pelota::update(float factorVel, const Tick& tick) {
 // Solo actualizar si tenemos MIDI válido
 	
 
-	if (midi == nullptr) return;  // si midi no tiene canal, la ejecución termina.
+	if (eventos == nullptr) return;  // si no hay bus de eventos, la ejecución termina.
     
 	// Si está esperando nacer, no hacer nada más
-	// si lifespan < 0, la pelota ya murio, empieza la cuenta del tiempo desde que murió y se apaga la nota, envío un "sendNoteOff". Termina la función.
-	if(tiempoVital <=0){
-		esperandoNacer = true;
-		tiempoDefuncion = ofGetElapsedTimef();
-		
-		if(noteOn){
-			midi->sendNoteOff(note);
-			noteOn = false;
-		}
-		return;
+	if (esperandoNacer) return;
+	
+	// La nota de un obstáculo suena un solo frame, como la de la pelota
+	if (notaObstaculo >= 0) {
+		publicar(SIM_NOTA_OFF, notaObstaculo);
+		notaObstaculo = -1;
 	}
+	
 	// Movimiento
-	pos += vel * factorVel;     // Control de la velocidad y la posición, se puede ajustar en tiempo real
-	tiempoVital -= 2 ;		    // cuenta regresiva desde el nacimiento a la muerte
+	posAnterior = pos;          // inicio del recorrido de este frame (para los choques barridos)
+	desviada = false;
 	
 	bool rebote = false;        // inicializo la variable rebote. 
-		
+	
+	// Sub-pasos: si en este frame la pelota recorre más que su radio,
+	// el recorrido se parte en tramos más cortos que el radio.
+	// Las pelotas lentas (la mayoría) hacen un solo tramo.
+	float recorrido = vel.length() * factorVel;   // Control de la velocidad, se puede ajustar en tiempo real
+	int subpasos = max(1, (int)ceil(recorrido / radio));
+	
+	for (int s = 0; s < subpasos; s++)
+		if (moverConRebotes(vel * (factorVel / subpasos), tick))
+			rebote = true;
+	
+	// Manejo de NOTE ON / NOTE OFF
+	// la nota empieza al momento del rebote
+	if (rebote && !noteOn) {
+		publicar(SIM_NOTA_ON, note);
+		noteOn = true;
+	}
+	// "Suelta la tecla" (Note Off) en el momento posterior al rebote
+	else if (!rebote && noteOn) {
+		publicar(SIM_NOTA_OFF, note);
+		noteOn = false;
+	}
+	
+}
+
+/*
+--------------------------------------------------------------
+ moverConRebotes(mov, tick)
+ 
+ Mueve la pelota un tramo "mov" y resuelve los rebotes contra las paredes.
+ 
 // --------------------------------
 // REBOTES
 // Si una de las pelotas "toca" alguno de los bordes del rectangulo donde viven,
-// el centro de la bola "frena" a un radio de distancia del marco e invierte su velocidad,
-// sale para el otro lado, eso se cuenta como un rebote => rebote = true. Esta condición va a enviar un noteOn.
+// se calcula en qué momento del tramo lo tocó (tiempoImpactoPared), el centro
+// de la bola "frena" a un radio de distancia del marco e invierte su velocidad,
+// y lo que le faltaba recorrer lo recorre para el otro lado. Así no se pierde
+// camino ni se queda incrustada en la pared a velocidades altas.
+// Eso se cuenta como un rebote => devuelve true. Esta condición va a enviar un noteOn.
 //---------------------------------
+ 
+ Si la pelota ya estaba fuera del marco (por ejemplo al nacer en un rincón
+ en modo aCordes), se la acomoda contra la pared como antes.
+ Al final de cada tramo se consultan los obstáculos (rebotarObstaculos).
+--------------------------------------------------------------
+ */
+
+bool Pelota::moverConRebotes(ofVec2f mov, const Tick& tick) {
+	
+	bool rebote = false;
+	int lado;
+	
+	// Eje horizontal: paredes izquierda y derecha
+	float t = tiempoImpactoPared(pos.x, mov.x, radio, limites.getLeft(), limites.getRight(), lado);
+	if (t >= 0) {
+		pos.x += mov.x * t - mov.x * (1 - t);  // llega a la pared y vuelve lo que le faltaba
+		vel.x *= -1;
+		rebote = true;
+		desviada = true;
+		tocarPared(lado < 0 ? PARED_IZQUIERDA : PARED_DERECHA, tick);
+	}
+	else
+		pos.x += mov.x;
+	
+	// Eje vertical: paredes de arriba y abajo
+	t = tiempoImpactoPared(pos.y, mov.y, radio, limites.getTop(), limites.getBottom(), lado);
+	if (t >= 0) {
+		pos.y += mov.y * t - mov.y * (1 - t);
+		vel.y *= -1;
+		rebote = true;
+		desviada = true;
+		tocarPared(lado < 0 ? PARED_ARRIBA : PARED_ABAJO, tick);
+	}
+	else
+		pos.y += mov.y;
 	
     // Pared izquierda
 	if (pos.x - radio < limites.getLeft()) {
 		vel.x *= -1;
 		pos.x = limites.getLeft() + radio;
 		rebote = true;
-		midi->sendControlChange(9, 127);  // envio en mensaje midi cc9 para abrir un envío en ableton
-		ccOpenTime_1 = ofGetElapsedTimeMillis(); // cuenta el tiempo de envio del mensaje
+		tocarPared(PARED_IZQUIERDA, tick);
 	}
 	
     // Pared derecha
@@ -183,8 +358,7 @@ void Pelota::update(float factorVel) {
 		vel.x *= -1;
 		pos.x = limites.getRight() - radio;
 		rebote = true;
-		midi->sendControlChange(7, 127);  // envio en mensaje midi cc7 para abrir un envío en ableton
-		ccOpenTime_1 = ofGetElapsedTimeMillis(); // cuenta el tiempo de envio del mensaje
+		tocarPared(PARED_DERECHA, tick);
 	}
 	
     // Pared de arriba
@@ -192,6 +366,7 @@ void Pelota::update(float factorVel) {
 		vel.y *= -1;
 		pos.y = limites.getTop() + radio;
 		rebote = true;
+		tocarPared(PARED_ARRIBA, tick);
 	}
 	
     // Pared de abajo
@@ -199,56 +374,103 @@ void Pelota::update(float factorVel) {
 		vel.y *= -1;
 		pos.y = limites.getBottom() - radio;
 		rebote = true;
+		tocarPared(PARED_ABAJO, tick);
 	}
 	
-	// Manejo del envío de NOTE ON / NOTE OFF
-	// manda la nota al momento del rebote
-	if (rebote && !noteOn) {
-		midi->sendNoteOn(note, 100);
-		noteOn = true;
-	}
-	// "Suelta la tecla" (Note Off) en el momento posterior al rebote
-	else if (!rebote && noteOn) {
-		midi->sendNoteOff(note);
-		noteOn = false;
-	}
+	if (obstaculos != nullptr && rebotarObstaculos())
+		rebote = true;
 	
+	if (rebote) desviada = true;
+	return rebote;
+}
+
+void Pelota::acotarAlMarco() {
+	pos.x = ofClamp(pos.x, limites.getLeft() + radio, limites.getRight() - radio);
+	pos.y = ofClamp(pos.y, limites.getTop() + radio, limites.getBottom() - radio);
+}
+
 /*
- Si nació (esparandoNacer = false) la funcion termina.
- Si el tiempoCumplido es mayor a dulce espera,
- se resetean la variables caracteristicas y vitales de la nueva pelota
- la pelota ya nació. la función termina su ejecución.
-*/
+--------------------------------------------------------------
+ rebotarObstaculos()
+ 
+ Una sola consulta al campo de distancias (Obstaculos::contacto),
+ haya los obstáculos que haya. Si la pelota entró en uno, se la
+ saca por la normal y, si venía hacia él, se refleja la velocidad.
+ Eso cuenta como rebote: con la nota de la pelota, o con la nota
+ propia del obstáculo si la tiene. El rebote se publica con la nota
+ y el CC del obstáculo (SIM_OBSTACULO).
+ Si ya se estaba alejando (sigue apoyada), no suena de nuevo.
+--------------------------------------------------------------
+ */
+
+bool Pelota::rebotarObstaculos() {
 	
-	bool tiempoCumplido = (ofGetElapsedTimef() - tiempoDefuncion >= dulceEspera);
-	if (esperandoNacer) {
-		if (tiempoCumplido) {
-			reset(limites);
-			esperandoNacer = false;
-		}
-		return;
-	}
+	ContactoObstaculo c;
+	if (!obstaculos->contacto(pos, radio, c)) return false;
+	
+	pos += c.normal * c.penetracion;
+	desviada = true;
 	
+	float hacia = vel.dot(c.normal);
+	if (hacia >= 0) return false;
+	vel -= c.normal * (2 * hacia);
+	
+	EventoSimulacion e;
+	e.tipo = SIM_OBSTACULO;
+	e.nota = c.nota;
+	e.cc = c.cc;
+	e.salida = salida;
+	e.x = pos.x - c.normal.x * radio;   // el punto de contacto
+	e.y = pos.y - c.normal.y * radio;
+	eventos->publicar(e);
+	
+	if (c.nota < 0) return true;   // suena la nota de la pelota
+	
+	if (notaObstaculo < 0) {
+		publicar(SIM_NOTA_ON, c.nota);
+		notaObstaculo = c.nota;
+	}
+	return false;
+}
+
+//--------------------------------------------------------------
+// tocarPared(pared, tick)
+// Publica el rebote con la pared que tocó. Con la izquierda y la
+// derecha MidiSender abre un envío en ableton (cc9 y cc7).
+//--------------------------------------------------------------
+
+void Pelota::tocarPared(ParedMarco pared, const Tick& tick) {
+	EventoSimulacion e;
+	e.tipo = SIM_PARED;
+	e.pared = pared;
+	e.salida = salida;
+	e.x = pos.x;
+	e.y = pos.y;
+	eventos->publicar(e);
+	if (pared == PARED_IZQUIERDA || pared == PARED_DERECHA)
+		ccOpenTime_1 = tick.milis;               // cuenta el tiempo de envio del mensaje
 }
 
 /*
 --------------------------------------------------------------
-draw()
- Dibuja un círculo colorido cuyo color depende de la nota MIDI.
- La transparencia está basada en tiempoVital para un efecto dinámico
+visual(v, tick)
+ Calcula el círculo colorido cuyo color depende de la nota MIDI.
+ La transparencia está basada en la vida restante para un efecto dinámico
  acompañando la desaparición de la pelota.
+ No dibuja: llena una PelotaVisual de la instantánea, que después
+ dibuja ofApp::draw() (posiblemente desde otro hilo).
 --------------------------------------------------------------
  */
 
-void Pelota::draw() {
+bool Pelota::visual(PelotaVisual& v, uint64_t tick) {
 	
-	if(esperandoNacer) return; // Si está esperando nacer, no dibuja nada.
+	if(esperandoNacer) return false; // Si está esperando nacer, no dibuja nada.
 	
 	int colorHue = (note * 8) % 360;  // Colores súper saturados
 	
-	ofSetColor(ofColor::fromHsb(colorHue, 255, 255), tiempoVital);  // acá manejamos el tiempo de vida
-	ofFill();
-	ofDrawCircle(pos, radio);
+	v.x = pos.x;
+	v.y = pos.y;
+	v.radio = radio;
+	v.color = ofColor::fromHsb(colorHue, 255, 255, ofClamp(vidaRestante(tick), 0, 255));  // acá manejamos el tiempo de vida
+	return true;
 }
-
-
@@ -1,8 +1,13 @@
 #pragma once
 #include "ofMain.h"
-#include "MidiSender.h"
+#include "busEventos.h"
 #include "ofxGui.h"
 #include "controlGui.h"
+#include "instantanea.h"
+#include "reloj.h"
+#include "azar.h"
+#include "estadoGuardado.h"
+#include "obstaculos.h"
 
 /*
 --------------------------------------------------------------
@@ -31,46 +36,100 @@ public:
 	// Inicialización basica
 	void setup();
 	
-	// Inicialización completa, con MIDI + vida + posición
-	void setup(ofRectangle marco, MidiSender* midiSender, int midiNote, float radio, int vida);
+	// Inicialización completa, con bus de eventos + vida + posición.
+	// "semilla" inicia el generador propio de la pelota (velocidad, renacimiento).
+	void setup(ofRectangle marco, BusEventos* bus, int midiNote, float radio, int vida, uint64_t semilla);
 	
-	// Actualiza movimiento, velocidad, rebotes, tiempo de vida y MIDI
-	void update(float factorVel = 1.0);
+	// Actualiza movimiento, velocidad y rebotes, y publica lo que suena.
+	// "tick" trae la hora del tick, la misma para todas las pelotas.
+	void update(float factorVel, const Tick& tick);
 	
-	// Dibuja en pantalla
-	void draw();
+	// Completa lo necesario para dibujarla. Devuelve false si no se ve.
+	// La transparencia sale de la vida que le queda en el tick "tick".
+	bool visual(PelotaVisual& v, uint64_t tick);
+	
+	// Vida y muerte agendadas (ver RuedaTemporizadores en ofApp).
+	// La vida no se descuenta en cada update: se calcula desde el tick de nacimiento.
+	void nacer(uint64_t tick) { tickNacimiento = tick; }
+	float vidaRestante(uint64_t tick) { return tiempoVital - 2.0f * (float)(tick - tickNacimiento); }
+	uint64_t tickMuerte();
+	
+	// Muere en este tick: apaga su nota y queda esperando nacer.
+	void morir(const Tick& tick);
 	
 	// Renacimiento con nuevos valores
 	void reset(ofRectangle marco);
 	
+	// Suelta la nota si está sonando (antes de sacar la pelota del pool)
+	void silenciar();
+	
+	// Copia del estado completo para un punto de control, y vuelta.
+	// "desplazamiento" corre los tiempos guardados al reloj actual.
+	// "tick" es el tick actual: la vida se guarda ya descontada, y al cargar
+	// la pelota "nace" de nuevo en ese tick con lo que le quedaba.
+	void guardarEstado(EstadoPelota& e, uint64_t tick);
+	void cargarEstado(const EstadoPelota& e, ofRectangle marco, BusEventos* bus, double desplazamiento, uint64_t tick);
+	bool estaSonando() { return noteOn; }
+	int getNota() { return note; }
+	int getSalida() { return salida; }
+	
 	// Setters
 	void setPos(ofVec2f nuevaPos) { pos = nuevaPos; }
 	void setVel(ofVec2f nuevaVel) { vel = nuevaVel; }
+	void setSalida(int s) { salida = s; }   // salida MIDI de sus notas (MidiSender::elegirSalida)
+	void setObstaculos(const Obstaculos* o) { obstaculos = o; }  // contra qué más rebota, nullptr = solo paredes
+	
+	// Vuelve a meter el centro dentro de los límites si una corrección de
+	// afuera (un choque entre pelotas) lo dejó pasar la pared. La velocidad
+	// no cambia: si apunta a la pared, el próximo update rebota y suena.
+	void acotarAlMarco();
 	
 	// Getters
 	bool isDead();
 	float getRadio() { return radio; }
 	ofVec2f getPos() { return pos; }
 	ofVec2f getVel() { return vel; }
+	ofVec2f getPosAnterior() { return posAnterior; }
+	bool seDesvio() { return desviada; }  // rebotó o la empujó un obstáculo en el último update
 	
 	// Variables
 	ofVec2f pos, vel;
+	ofVec2f posAnterior;       // posición al comenzar el último update
 	
 	// Estado de vida de la pelota
 	bool esperandoNacer = false;  // si espera nacer, no está viva.
-	float tiempoVital;
+	float tiempoVital;            // vida al nacer; se consume de a 2 por tick
+	uint64_t tickNacimiento = 0;  // tick desde el que se cuenta tiempoVital
 	
 	// Tiempos de muerte y renacimiento
 	float tiempoDefuncion = 0;
 	float dulceEspera = 4.0f; 
 
-	int ccOpenTime_1;
+	int ccOpenTime_1 = 0;
 	
 private:
 	
+	// Mueve un tramo y rebota contra las paredes. Devuelve true si rebotó.
+	bool moverConRebotes(ofVec2f mov, const Tick& tick);
+	
+	// Publica el rebote contra una pared; las de los costados abren un "envío"
+	void tocarPared(ParedMarco pared, const Tick& tick);
+	
+	// Publica un evento de la pelota, en su posición y con su salida
+	void publicar(TipoEventoSimulacion tipo, int nota = -1);
+	
+	// Rebota contra los obstáculos. Devuelve true si es un rebote con la nota
+	// de la pelota; si el obstáculo tiene nota propia, la toca él.
+	bool rebotarObstaculos();
+	
 	ofRectangle limites;    // límites de movimiento
-	MidiSender* midi;       // puntero MIDI
+	Azar azar;              // generador propio: no comparte estado con otras pelotas ni hilos
+	BusEventos* eventos;    // a dónde van sus notas y rebotes (MIDI, registro, visuales)
+	const Obstaculos* obstaculos = nullptr;
+	int notaObstaculo = -1; // nota propia de un obstáculo que está sonando
+	bool desviada = false;  // el recorrido del último update no fue una recta
 	bool noteOn = false;    // Si está sonando la nota
 	float radio;            // tamaño pelota
 	int note = 60;          // nota MIDI inicializada
+	int salida = 0;         // salida MIDI por la que salen sus notas
 };
@@ -0,0 +1,52 @@
+/*
+--------------------------------------------------------------
+ planificadorFrames.cpp
+
+ Implementación de la clase PlanificadorFrames
+--------------------------------------------------------------
+*/
+
+#include "planificadorFrames.h"
+
+void PlanificadorFrames::setup(int activo, int reposo)
+{
+	fpsActivo = activo;
+	fpsReposo = reposo;
+	estado = ACTIVO;
+}
+
+/*
+--------------------------------------------------------------
+ actualizar(hayActividad, proximoNacimiento, ahora)
+ Pasa a REPOSO solo si no hay actividad, no hubo entrada reciente y
+ el próximo nacimiento está más lejos que un frame de reposo.
+ Cualquier pedido de despertar vuelve a ACTIVO en este mismo frame.
+--------------------------------------------------------------
+*/
+
+void PlanificadorFrames::actualizar(bool hayActividad, double proximoNacimiento, double ahora)
+{
+	if(despertarPedido.exchange(false))
+		ultimaActividad = ahora;
+	
+	bool despierto = hayActividad || (ahora - ultimaActividad < segundosDespierto);
+	
+	// un frame de reposo antes del nacimiento ya hay que estar a ritmo normal
+	if(proximoNacimiento >= 0 && proximoNacimiento - ahora < 1.0 / fpsReposo)
+		despierto = true;
+	
+	cambiarEstado(despierto ? ACTIVO : REPOSO);
+}
+
+void PlanificadorFrames::cambiarEstado(Estado nuevo)
+{
+	if(nuevo == estado) return;
+	
+	estado = nuevo;
+	ofSetFrameRate(estado == ACTIVO ? fpsActivo : fpsReposo);
+	
+	// al entrar en reposo se dibuja una vez más, para que la imagen
+	// guardada sea la del estado quieto (sin las últimas pelotas)
+	if(estado == REPOSO)
+		dibujoPendiente = true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ planificadorFrames.h
+
+ Clase PlanificadorFrames
+
+ Baja el ritmo de frames cuando no hay nada que mostrar.
+ La instalación puede pasar días sola, y la mayor parte del tiempo
+ está esperando la dulce espera o sin pelotas (regeneración apagada):
+ en esos momentos no tiene sentido redibujar los FBO a 60 fps.
+
+   - ACTIVO:  hay pelotas vivas, un morph en curso o actividad reciente.
+              Ritmo normal, las pelotas se dibujan en cada frame.
+   - REPOSO:  no hay pelotas. Baja a fpsReposo y draw() presenta la
+              última imagen de las pelotas sin volver a dibujarla.
+
+ Se despierta:
+   - con teclado o mouse (despertar), y se queda despierto un rato,
+   - con sonido en la entrada de audio por encima de un umbral,
+   - un poco antes del próximo nacimiento programado, para que la
+     nueva generación arranque a ritmo normal.
+--------------------------------------------------------------
+*/
+
+class PlanificadorFrames
+{
+public:
+	enum Estado { ACTIVO, REPOSO };
+	
+	// Ritmos de frames en cada estado
+	void setup(int fpsActivo = 60, int fpsReposo = 6);
+	
+	// Actividad del usuario (cualquier hilo)
+	void despertar() { despertarPedido = true; }
+	
+	// Nivel de la entrada de audio (hilo de audio)
+	void nivelAudio(float nivel) { if(nivel > umbralAudio) despertarPedido = true; }
+	
+	// Decide el estado del frame (hilo del GUI, una vez por frame).
+	//   hayActividad      - hay pelotas vivas o algo moviéndose
+	//   proximoNacimiento - hora del próximo nacimiento programado, o < 0 si no hay
+	//   ahora             - hora actual en segundos
+	void actualizar(bool hayActividad, double proximoNacimiento, double ahora);
+	
+	// true si este frame tiene que volver a dibujar las pelotas en los FBO
+	bool redibujarPelotas() { return estado == ACTIVO || dibujoPendiente; }
+	
+	// Avisa que las pelotas ya se dibujaron en este frame
+	void pelotasDibujadas() { dibujoPendiente = false; }
+	
+	Estado getEstado() { return estado; }
+	int getFpsActivo() { return fpsActivo; }   // el ritmo de los ticks con pelotas vivas
+	int getFpsReposo() { return fpsReposo; }   // el ritmo más bajo al que corren los ticks
+	
+	float umbralAudio = 0.05f;      // RMS de la entrada que despierta
+	float segundosDespierto = 3.0f; // cuánto dura despierto después de actividad
+	
+private:
+	void cambiarEstado(Estado nuevo);
+	
+	Estado estado = ACTIVO;
+	int fpsActivo = 60;
+	int fpsReposo = 6;
+	std::atomic<bool> despertarPedido{false};
+	double ultimaActividad = 0;
+	bool dibujoPendiente = false;   // una última pasada para dejar la imagen en reposo
+};
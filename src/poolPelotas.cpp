@@ -0,0 +1,144 @@
+/*
+--------------------------------------------------------------
+ poolPelotas.cpp
+
+ Implementación de la clase PoolPelotas
+ 
+ Todos los vectores se dimensionan en setup() y después solo se
+ usan dentro de su capacidad reservada (push_back/pop_back sobre
+ memoria ya pedida), así que el estado estable no pide memoria.
+--------------------------------------------------------------
+*/
+
+#include "poolPelotas.h"
+
+/*
+--------------------------------------------------------------
+ setup(capacidad, politica)
+ Reserva los lugares y deja todos en la lista de libres.
+ Los libres se apilan al revés para que el primer nacimiento
+ use el lugar 0.
+--------------------------------------------------------------
+*/
+
+void PoolPelotas::setup(int capacidad, PoliticaPool p)
+{
+	politica = p;
+	
+	lugares.assign(capacidad, Pelota());
+	generaciones.assign(capacidad, 0);
+	nacimientos.assign(capacidad, 0);
+	posicionViva.assign(capacidad, -1);
+	
+	libres.clear();
+	libres.reserve(capacidad);
+	for(int i = capacidad - 1; i >= 0; i--)
+		libres.push_back(i);
+	
+	vivas.clear();
+	vivas.reserve(capacidad);
+}
+
+/*
+--------------------------------------------------------------
+ crear(manejador)
+ Saca un lugar de la pila de libres. Si no hay, aplica la política:
+ rechaza, o libera la pelota viva más vieja (búsqueda lineal, solo
+ ocurre con el pool lleno) y usa su lugar.
+--------------------------------------------------------------
+*/
+
+Pelota* PoolPelotas::crear(ManejadorPelota* manejador)
+{
+	if(libres.empty()) {
+		if(politica == POOL_RECHAZAR_NUEVAS || vivas.empty()) {
+			rechazadas++;
+			return nullptr;
+		}
+		
+		int masVieja = 0;
+		for(int i = 1; i < vivas.size(); i++)
+			if(nacimientos[vivas[i]] < nacimientos[vivas[masVieja]])
+				masVieja = i;
+		
+		lugares[vivas[masVieja]].silenciar();
+		liberar(masVieja);
+		reemplazadas++;
+	}
+	
+	int indice = libres.back();
+	libres.pop_back();
+	
+	posicionViva[indice] = vivas.size();
+	vivas.push_back(indice);
+	nacimientos[indice] = contadorNacimientos++;
+	
+	lugares[indice] = Pelota();   // vuelve a los valores por defecto, sin pedir memoria
+	
+	if(manejador != nullptr) {
+		manejador->indice = indice;
+		manejador->generacion = generaciones[indice];
+	}
+	return &lugares[indice];
+}
+
+//--------------------------------------------------------------
+// liberarLugar()
+//  Saca el lugar de "vivas" cambiándolo por el último (O(1)),
+//  invalida los manejadores viejos y lo devuelve a la pila.
+//--------------------------------------------------------------
+
+void PoolPelotas::liberarLugar(int indice)
+{
+	int pos = posicionViva[indice];
+	if(pos < 0) return;
+	
+	int ultimo = vivas.back();
+	vivas[pos] = ultimo;
+	posicionViva[ultimo] = pos;
+	vivas.pop_back();
+	
+	posicionViva[indice] = -1;
+	generaciones[indice]++;
+	libres.push_back(indice);
+}
+
+void PoolPelotas::liberar(int i)
+{
+	liberarLugar(vivas[i]);
+}
+
+bool PoolPelotas::liberar(ManejadorPelota manejador)
+{
+	if(obtener(manejador) == nullptr) return false;
+	liberarLugar(manejador.indice);
+	return true;
+}
+
+void PoolPelotas::liberarTodas()
+{
+	while(!vivas.empty())
+		liberarLugar(vivas.back());
+}
+
+//--------------------------------------------------------------
+// obtener() / getManejador()
+//  Un manejador es válido si su lugar está ocupado y la
+//  generación coincide con la que tenía al nacer.
+//--------------------------------------------------------------
+
+Pelota* PoolPelotas::obtener(ManejadorPelota manejador)
+{
+	int i = manejador.indice;
+	if(i < 0 || i >= lugares.size()) return nullptr;
+	if(posicionViva[i] < 0 || generaciones[i] != manejador.generacion) return nullptr;
+	return &lugares[i];
+}
+
+ManejadorPelota PoolPelotas::getManejador(int i)
+{
+	ManejadorPelota m;
+	m.indice = vivas[i];
+	m.generacion = generaciones[m.indice];
+	return m;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "ofMain.h"
+#include "pelota.h"
+
+/*
+--------------------------------------------------------------
+ poolPelotas.h
+
+ Clase PoolPelotas
+
+ Reserva de pelotas de capacidad fija. Reemplaza al vector que
+ crecía con push_back en cada nacimiento:
+
+   - Toda la memoria se reserva una sola vez en setup(); nacer y
+     morir no piden ni liberan memoria.
+   - Los lugares libres se guardan en una lista (pila) y se
+     reutilizan en el próximo nacimiento.
+   - Las pelotas vivas se recorren en forma contigua con size() y
+     el operador [], como antes con el vector.
+   - Cada lugar tiene un número de generación que aumenta al
+     liberarse. Un ManejadorPelota guardado antes de la muerte
+     deja de ser válido y obtener() devuelve nullptr.
+   - Si no hay lugar, la política decide: rechazar la nueva pelota
+     o reemplazar a la más vieja.
+--------------------------------------------------------------
+*/
+
+// Referencia estable a una pelota del pool
+struct ManejadorPelota {
+	int indice = -1;
+	uint32_t generacion = 0;
+};
+
+// Qué hacer cuando se pide una pelota y el pool está lleno
+enum PoliticaPool {
+	POOL_RECHAZAR_NUEVAS,    // la pelota nueva no nace
+	POOL_REEMPLAZAR_VIEJAS   // muere la pelota viva más vieja y se usa su lugar
+};
+
+class PoolPelotas
+{
+public:
+	// Reserva la memoria para "capacidad" pelotas
+	void setup(int capacidad, PoliticaPool politica = POOL_RECHAZAR_NUEVAS);
+	
+	// Toma un lugar libre y lo devuelve con una Pelota por defecto.
+	// Devuelve nullptr si el pool está lleno y la política es rechazar.
+	Pelota* crear(ManejadorPelota* manejador = nullptr);
+	
+	// Devuelve al pool la i-ésima pelota viva. La última viva pasa a
+	// ocupar la posición i, así que al recorrer no hay que avanzar i.
+	void liberar(int i);
+	
+	// Devuelve al pool la pelota del manejador, si sigue siendo válido
+	bool liberar(ManejadorPelota manejador);
+	
+	// Libera todas las pelotas vivas
+	void liberarTodas();
+	
+	// Pelota del manejador, o nullptr si ya murió
+	Pelota* obtener(ManejadorPelota manejador);
+	ManejadorPelota getManejador(int i);
+	
+	// Recorrido de las pelotas vivas
+	int size() { return vivas.size(); }
+	Pelota& operator[](int i) { return lugares[vivas[i]]; }
+	
+	// Configuración y estadísticas
+	void setPolitica(PoliticaPool p) { politica = p; }
+	int getCapacidad() { return lugares.size(); }
+	uint64_t getRechazadas() { return rechazadas; }
+	uint64_t getReemplazadas() { return reemplazadas; }
+	
+private:
+	void liberarLugar(int indice);
+	
+	vector<Pelota> lugares;             // todas las pelotas, vivas o no
+	vector<uint32_t> generaciones;      // generación actual de cada lugar
+	vector<uint64_t> nacimientos;       // orden de nacimiento, para reemplazar la más vieja
+	vector<int> posicionViva;           // posición de cada lugar en "vivas", -1 si está libre
+	vector<int> libres;                 // pila de lugares libres
+	vector<int> vivas;                  // lugares ocupados, contiguos
+	
+	PoliticaPool politica = POOL_RECHAZAR_NUEVAS;
+	uint64_t contadorNacimientos = 0;
+	uint64_t rechazadas = 0;
+	uint64_t reemplazadas = 0;
+};
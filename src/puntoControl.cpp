@@ -0,0 +1,200 @@
+/*
+--------------------------------------------------------------
+ puntoControl.cpp
+
+ Implementación de la clase PuntoControl
+--------------------------------------------------------------
+*/
+
+#include "puntoControl.h"
+
+#ifndef TARGET_WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool PuntoControl::abrir(const string& ruta, int capacidadPelotas)
+{
+#ifdef TARGET_WIN32
+	ofLogWarning("PuntoControl") << "Sin mmap en esta plataforma: no hay puntos de control";
+	return false;
+#else
+	cerrar();
+	capacidad = capacidadPelotas;
+	tamanoMapa = sizeof(Cabecera) + 2 * tamanoRanura();
+	
+	descriptor = ::open(ruta.c_str(), O_RDWR | O_CREAT, 0644);
+	if(descriptor < 0) {
+		ofLogError("PuntoControl") << "No se pudo abrir " << ruta;
+		return false;
+	}
+	
+	off_t tamanoArchivo = lseek(descriptor, 0, SEEK_END);
+	if(tamanoArchivo != (off_t)tamanoMapa && ftruncate(descriptor, tamanoMapa) != 0) {
+		ofLogError("PuntoControl") << "No se pudo dimensionar " << ruta;
+		cerrar();
+		return false;
+	}
+	
+	void* direccion = mmap(nullptr, tamanoMapa, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	if(direccion == MAP_FAILED) {
+		ofLogError("PuntoControl") << "No se pudo mapear " << ruta;
+		cerrar();
+		return false;
+	}
+	mapa = (uint8_t*)direccion;
+	
+	// Otro formato u otra capacidad: se empieza de cero
+	Cabecera* cabecera = (Cabecera*)mapa;
+	bool coincide = memcmp(cabecera->magia, "TFPC", 4) == 0 &&
+					cabecera->version == VERSION_PUNTO_CONTROL &&
+					cabecera->capacidad == (uint32_t)capacidad &&
+					cabecera->tamanoPelota == sizeof(EstadoPelota) &&
+					cabecera->tamanoSimulacion == sizeof(EstadoSimulacion);
+	if(!coincide) {
+		if(tamanoArchivo > 0)
+			ofLogNotice("PuntoControl") << "El punto de control guardado es de otro formato, se descarta";
+		memset(mapa, 0, tamanoMapa);
+		memcpy(cabecera->magia, "TFPC", 4);
+		cabecera->version = VERSION_PUNTO_CONTROL;
+		cabecera->capacidad = capacidad;
+		cabecera->tamanoPelota = sizeof(EstadoPelota);
+		cabecera->tamanoSimulacion = sizeof(EstadoSimulacion);
+	}
+	
+	// La próxima escritura va a la ranura que no tiene el último estado
+	int valida = ranuraValida();
+	ranuraEscritura = valida == 0 ? 1 : 0;
+	secuencia = valida >= 0 ? ranura(valida)->secuencia : 0;
+	return true;
+#endif
+}
+
+void PuntoControl::cerrar()
+{
+#ifndef TARGET_WIN32
+	if(mapa != nullptr) {
+		msync(mapa, tamanoMapa, MS_ASYNC);
+		munmap(mapa, tamanoMapa);
+		mapa = nullptr;
+	}
+	if(descriptor >= 0) {
+		::close(descriptor);
+		descriptor = -1;
+	}
+#endif
+}
+
+size_t PuntoControl::tamanoRanura() const
+{
+	return sizeof(CabeceraRanura) + sizeof(EstadoSimulacion) + capacidad * sizeof(EstadoPelota);
+}
+
+PuntoControl::CabeceraRanura* PuntoControl::ranura(int r)
+{
+	return (CabeceraRanura*)(mapa + sizeof(Cabecera) + r * tamanoRanura());
+}
+
+EstadoSimulacion* PuntoControl::simulacion(int r)
+{
+	return (EstadoSimulacion*)((uint8_t*)ranura(r) + sizeof(CabeceraRanura));
+}
+
+EstadoPelota* PuntoControl::pelotas(int r)
+{
+	return (EstadoPelota*)((uint8_t*)simulacion(r) + sizeof(EstadoSimulacion));
+}
+
+// FNV-1a sobre la simulación y las pelotas vivas de la ranura
+uint64_t PuntoControl::sumar(int r)
+{
+	EstadoSimulacion* sim = simulacion(r);
+	int cantidad = ofClamp(sim->cantidadPelotas, 0, capacidad);
+	const uint8_t* datos = (const uint8_t*)sim;
+	size_t largo = sizeof(EstadoSimulacion) + cantidad * sizeof(EstadoPelota);
+	
+	uint64_t suma = 14695981039346656037ull;
+	for(size_t i = 0; i < largo; i++) {
+		suma ^= datos[i];
+		suma *= 1099511628211ull;
+	}
+	return suma;
+}
+
+// Ranura completa con la secuencia más alta, o -1
+int PuntoControl::ranuraValida()
+{
+	int mejor = -1;
+	for(int r = 0; r < 2; r++) {
+		CabeceraRanura* c = ranura(r);
+		if(c->secuencia == 0 || (c->secuencia & 1)) continue;
+		if(simulacion(r)->cantidadPelotas < 0 || simulacion(r)->cantidadPelotas > capacidad) continue;
+		if(c->suma != sumar(r)) continue;
+		if(mejor < 0 || c->secuencia > ranura(mejor)->secuencia) mejor = r;
+	}
+	return mejor;
+}
+
+const EstadoSimulacion* PuntoControl::leerSimulacion()
+{
+	if(mapa == nullptr) return nullptr;
+	int r = ranuraValida();
+	return r >= 0 ? simulacion(r) : nullptr;
+}
+
+const EstadoPelota* PuntoControl::leerPelotas()
+{
+	if(mapa == nullptr) return nullptr;
+	int r = ranuraValida();
+	return r >= 0 ? pelotas(r) : nullptr;
+}
+
+/*
+--------------------------------------------------------------
+ comenzar() / escribirPelota() / terminar()
+ La ranura queda marcada como incompleta (secuencia impar) desde
+ comenzar() hasta terminar(), que escribe la suma y la secuencia par.
+--------------------------------------------------------------
+*/
+
+void PuntoControl::comenzar()
+{
+	if(mapa == nullptr) return;
+	ranura(ranuraEscritura)->secuencia = secuencia + 1;
+}
+
+void PuntoControl::escribirPelota(int i, const EstadoPelota& pelota)
+{
+	if(mapa == nullptr || i >= capacidad) return;
+	EstadoPelota* destino = pelotas(ranuraEscritura) + i;
+	if(memcmp(destino, &pelota, sizeof(EstadoPelota)) != 0) {
+		*destino = pelota;
+		pelotasCopiadas++;
+	}
+}
+
+void PuntoControl::terminar(const EstadoSimulacion& sim)
+{
+	if(mapa == nullptr) return;
+	
+	EstadoSimulacion* destino = simulacion(ranuraEscritura);
+	*destino = sim;
+	destino->cantidadPelotas = min(sim.cantidadPelotas, capacidad);
+	
+	CabeceraRanura* c = ranura(ranuraEscritura);
+	c->suma = sumar(ranuraEscritura);
+	secuencia += 2;
+	c->secuencia = secuencia;
+	
+#ifndef TARGET_WIN32
+	// msync pide direcciones alineadas a página
+	uintptr_t pagina = sysconf(_SC_PAGESIZE);
+	uintptr_t inicio = (uintptr_t)c & ~(pagina - 1);
+	uintptr_t fin = (uintptr_t)c + tamanoRanura();
+	msync((void*)inicio, fin - inicio, MS_ASYNC);
+#endif
+	
+	ranuraEscritura = 1 - ranuraEscritura;
+	guardados++;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "ofMain.h"
+#include "estadoGuardado.h"
+
+/*
+--------------------------------------------------------------
+ puntoControl.h
+
+ Clase PuntoControl
+
+ Guarda el estado completo de la simulación en un archivo mapeado
+ en memoria, para retomar la función donde estaba si la aplicación
+ se cae o se reinicia en medio de una muestra.
+
+ Formato del archivo (tamaño fijo, según la capacidad del pool):
+
+   Cabecera | Ranura 0 | Ranura 1
+   Ranura = CabeceraRanura | EstadoSimulacion | EstadoPelota[capacidad]
+
+   - Se escribe alternando las ranuras: si se corta a mitad de una
+     escritura, la otra ranura sigue entera.
+   - Cada ranura lleva un número de secuencia (impar mientras se
+     escribe) y una suma de verificación. Al leer se usa la ranura
+     válida con la secuencia más alta.
+   - Escritura incremental: una pelota que no cambió desde la última
+     vez que se usó esa ranura no se vuelve a copiar, así sus páginas
+     no quedan sucias.
+   - Al terminar se pide msync(MS_ASYNC): el sistema baja las páginas
+     al disco por su cuenta y el tick no espera.
+   - Leer es mapear y mirar dos ranuras, sin interpretar nada.
+
+ En Windows no hay mmap: el punto de control queda desactivado.
+--------------------------------------------------------------
+*/
+
+class PuntoControl
+{
+public:
+	~PuntoControl() { cerrar(); }
+	
+	// Abre (o crea) el archivo y lo mapea. Si el formato no coincide, lo vacía.
+	bool abrir(const string& ruta, int capacidadPelotas);
+	void cerrar();
+	bool estaAbierto() { return mapa != nullptr; }
+	
+	// Lectura del último estado completo, o nullptr si no hay
+	const EstadoSimulacion* leerSimulacion();
+	const EstadoPelota* leerPelotas();
+	
+	// Escritura, desde el tick de simulación:
+	//   comenzar(); escribirPelota(i, ...) para cada pelota viva; terminar(sim);
+	void comenzar();
+	void escribirPelota(int i, const EstadoPelota& pelota);
+	void terminar(const EstadoSimulacion& simulacion);
+	
+	uint64_t getGuardados()        { return guardados; }
+	uint64_t getPelotasCopiadas()  { return pelotasCopiadas; }   // las que cambiaron
+	
+private:
+	struct Cabecera {
+		char magia[4];             // "TFPC"
+		uint32_t version;
+		uint32_t capacidad;
+		uint32_t tamanoPelota;
+		uint32_t tamanoSimulacion;
+		uint8_t relleno[44];
+	};
+	
+	struct CabeceraRanura {
+		uint64_t secuencia;        // impar = escritura en curso
+		uint64_t suma;             // FNV-1a de la simulación y las pelotas
+	};
+	
+	size_t tamanoRanura() const;
+	CabeceraRanura* ranura(int r);
+	EstadoSimulacion* simulacion(int r);
+	EstadoPelota* pelotas(int r);
+	uint64_t sumar(int r);
+	int ranuraValida();
+	
+	uint8_t* mapa = nullptr;
+	size_t tamanoMapa = 0;
+	int descriptor = -1;
+	int capacidad = 0;
+	
+	int ranuraEscritura = 0;
+	uint64_t secuencia = 0;
+	
+	uint64_t guardados = 0;
+	uint64_t pelotasCopiadas = 0;
+};
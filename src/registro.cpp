@@ -0,0 +1,136 @@
+/*
+--------------------------------------------------------------
+ registro.cpp
+
+ Implementación del Registro asincrónico.
+
+ Cada celda del anillo tiene un número de secuencia que dice de
+ quién es el turno: cuando vale "posición" la celda está libre para
+ el productor que tomó esa posición; cuando vale "posición + 1" tiene
+ una entrada lista para el consumidor. Los productores se reparten
+ las posiciones con un compare_exchange sobre "cola".
+--------------------------------------------------------------
+*/
+
+#include "registro.h"
+
+Registro::Registro()
+{
+	for(size_t i = 0; i < CAPACIDAD; i++)
+		celdas[i].secuencia.store(i, std::memory_order_relaxed);
+}
+
+Registro& Registro::instancia()
+{
+	static Registro registro;
+	return registro;
+}
+
+void Registro::iniciar()
+{
+	instancia().startThread();
+}
+
+void Registro::detener()
+{
+	Registro& r = instancia();
+	r.waitForThread(true);
+	r.vaciar();   // lo que quedó después del último ciclo del hilo
+}
+
+//--------------------------------------------------------------
+// encolar()
+//  Productores (cualquier hilo). Si la celda de la posición
+//  todavía no fue leída, el anillo está lleno: se descarta.
+//--------------------------------------------------------------
+
+void Registro::encolar(const Entrada& e)
+{
+	size_t pos = cola.load(std::memory_order_relaxed);
+	Celda* celda;
+	
+	while(true) {
+		celda = &celdas[pos & (CAPACIDAD - 1)];
+		size_t secuencia = celda->secuencia.load(std::memory_order_acquire);
+		intptr_t diferencia = (intptr_t)secuencia - (intptr_t)pos;
+		
+		if(diferencia == 0) {
+			if(cola.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if(diferencia < 0) {
+			descartados++;
+			return;
+		}
+		else
+			pos = cola.load(std::memory_order_relaxed);
+	}
+	
+	celda->entrada = e;
+	celda->secuencia.store(pos + 1, std::memory_order_release);
+}
+
+// Consumidor (solo el hilo del registro)
+bool Registro::desencolar(Entrada& e)
+{
+	Celda& celda = celdas[cabeza & (CAPACIDAD - 1)];
+	if(celda.secuencia.load(std::memory_order_acquire) != cabeza + 1)
+		return false;
+	
+	e = celda.entrada;
+	celda.secuencia.store(cabeza + CAPACIDAD, std::memory_order_release);
+	cabeza++;
+	return true;
+}
+
+//--------------------------------------------------------------
+// formatear()
+//  Reemplaza cada {} del formato por el argumento que le toca.
+//--------------------------------------------------------------
+
+void Registro::formatear(const Entrada& e, char* destino, size_t tam)
+{
+	size_t n = 0;
+	int arg = 0;
+	
+	for(const char* c = e.formato; *c && n + 1 < tam; c++) {
+		if(c[0] == '{' && c[1] == '}' && arg < e.numArgs) {
+			const ArgRegistro& a = e.args[arg++];
+			int escritos;
+			switch(a.tipo) {
+				case ArgRegistro::ENTERO: escritos = snprintf(destino + n, tam - n, "%lld", (long long)a.entero); break;
+				case ArgRegistro::REAL:   escritos = snprintf(destino + n, tam - n, "%g", a.real); break;
+				default:                  escritos = snprintf(destino + n, tam - n, "%s", a.texto); break;
+			}
+			n = min(n + max(escritos, 0), tam - 1);
+			c++;
+		}
+		else
+			destino[n++] = *c;
+	}
+	destino[n] = 0;
+}
+
+void Registro::vaciar()
+{
+	Entrada e;
+	char texto[512];
+	
+	while(desencolar(e)) {
+		formatear(e, texto, sizeof(texto));
+		switch(e.nivel) {
+			case NIVEL_VERBOSE: ofLogVerbose() << texto; break;
+			case NIVEL_NOTICE:  ofLogNotice()  << texto; break;
+			case NIVEL_WARNING: ofLogWarning() << texto; break;
+			default:            ofLogError()   << texto; break;
+		}
+	}
+}
+
+void Registro::threadedFunction()
+{
+	while(isThreadRunning()) {
+		vaciar();
+		sleep(5);
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ registro.h
+
+ Registro asincrónico para diagnóstico en los caminos calientes.
+
+ ofLogNotice() formatea y escribe en consola en el mismo momento,
+ en el hilo que lo llama. Con cientos de pelotas por generación
+ eso se nota en el frame. Con el Registro:
+
+   - REGISTRO_NOTICE("Pelota {} | radio: {}", i, radio) no formatea
+     nada: copia el puntero al formato (un literal) y los argumentos
+     (números o textos estáticos) a un anillo preasignado, sin bloqueo
+     y sin pedir memoria.
+   - Un hilo aparte saca las entradas, reemplaza cada {} por su
+     argumento y las manda a ofLog.
+   - Si el anillo está lleno, la entrada se descarta y se cuenta
+     (getDescartados), pero quien registra nunca espera.
+   - El nivel mínimo se fija al compilar con TF_NIVEL_REGISTRO; las
+     llamadas por debajo de ese nivel desaparecen del código.
+
+ Los textos que se pasan como argumento tienen que vivir para
+ siempre (literales o tablas estáticas): se formatean más tarde.
+--------------------------------------------------------------
+*/
+
+enum NivelRegistro {
+	NIVEL_VERBOSE = 0,
+	NIVEL_NOTICE,
+	NIVEL_WARNING,
+	NIVEL_ERROR
+};
+
+// Nivel mínimo compilado (se puede cambiar con -DTF_NIVEL_REGISTRO=0 en PROJECT_DEFINES)
+#ifndef TF_NIVEL_REGISTRO
+#define TF_NIVEL_REGISTRO NIVEL_NOTICE
+#endif
+
+#define REGISTRAR(nivel, ...) \
+	do { if ((nivel) >= TF_NIVEL_REGISTRO) Registro::escribir((nivel), __VA_ARGS__); } while(0)
+
+#define REGISTRO_VERBOSE(...) REGISTRAR(NIVEL_VERBOSE, __VA_ARGS__)
+#define REGISTRO_NOTICE(...)  REGISTRAR(NIVEL_NOTICE, __VA_ARGS__)
+#define REGISTRO_WARNING(...) REGISTRAR(NIVEL_WARNING, __VA_ARGS__)
+#define REGISTRO_ERROR(...)   REGISTRAR(NIVEL_ERROR, __VA_ARGS__)
+
+// Un argumento guardado sin formatear
+struct ArgRegistro {
+	enum Tipo : uint8_t { ENTERO, REAL, TEXTO } tipo;
+	union {
+		int64_t entero;
+		double real;
+		const char* texto;
+	};
+	
+	ArgRegistro(int v)                { tipo = ENTERO; entero = v; }
+	ArgRegistro(long v)               { tipo = ENTERO; entero = v; }
+	ArgRegistro(long long v)          { tipo = ENTERO; entero = v; }
+	ArgRegistro(unsigned int v)       { tipo = ENTERO; entero = v; }
+	ArgRegistro(unsigned long v)      { tipo = ENTERO; entero = (int64_t)v; }
+	ArgRegistro(unsigned long long v) { tipo = ENTERO; entero = (int64_t)v; }
+	ArgRegistro(float v)              { tipo = REAL; real = v; }
+	ArgRegistro(double v)             { tipo = REAL; real = v; }
+	ArgRegistro(const char* v)        { tipo = TEXTO; texto = v; }
+	ArgRegistro()                     { tipo = ENTERO; entero = 0; }
+};
+
+class Registro : public ofThread
+{
+public:
+	static const int MAX_ARGS = 6;
+	static const int CAPACIDAD = 1024;   // entradas en el anillo (potencia de 2)
+	
+	// Arranca / detiene el hilo que escribe (detener vacía lo pendiente)
+	static void iniciar();
+	static void detener();
+	
+	// Encola una entrada; no bloquea, no pide memoria
+	template<class... Args>
+	static void escribir(NivelRegistro nivel, const char* formato, Args... args) {
+		static_assert(sizeof...(Args) <= MAX_ARGS, "demasiados argumentos para el registro");
+		Entrada e;
+		e.nivel = nivel;
+		e.formato = formato;
+		e.numArgs = sizeof...(Args);
+		ArgRegistro lista[] = { ArgRegistro(args)..., ArgRegistro() };
+		for(int i = 0; i < (int)sizeof...(Args); i++) e.args[i] = lista[i];
+		instancia().encolar(e);
+	}
+	
+	// Entradas perdidas porque el anillo estaba lleno
+	static uint64_t getDescartados() { return instancia().descartados.load(); }
+	
+private:
+	struct Entrada {
+		NivelRegistro nivel;
+		const char* formato;
+		int numArgs;
+		ArgRegistro args[MAX_ARGS];
+	};
+	
+	// Anillo acotado de varios productores y un consumidor (Vyukov)
+	struct Celda {
+		std::atomic<size_t> secuencia;
+		Entrada entrada;
+	};
+	
+	Registro();
+	static Registro& instancia();
+	
+	void encolar(const Entrada& e);
+	bool desencolar(Entrada& e);
+	void formatear(const Entrada& e, char* destino, size_t tam);
+	void vaciar();
+	void threadedFunction();
+	
+	Celda celdas[CAPACIDAD];
+	std::atomic<size_t> cola{0};   // próxima posición a escribir (productores)
+	size_t cabeza = 0;             // próxima posición a leer (solo el hilo del registro)
+	std::atomic<uint64_t> descartados{0};
+};
@@ -0,0 +1,21 @@
+/*
+--------------------------------------------------------------
+ reloj.cpp
+
+ Implementación del Reloj por tick.
+--------------------------------------------------------------
+*/
+
+#include "reloj.h"
+
+const Tick& Reloj::muestrear()
+{
+	double ahora = fuente->ahora();
+	fuente->avanzar();
+	
+	tick.dt = tick.numero == 0 ? 0 : ahora - tick.segundos;
+	tick.segundos = ahora;
+	tick.milis = (uint64_t)(ahora * 1000.0);
+	tick.numero++;
+	return tick;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ reloj.h
+
+ Fuentes de tiempo y reloj por tick.
+
+ En lugar de que cada pelota pregunte la hora (ofGetElapsedTimef,
+ ofGetElapsedTimeMillis) varias veces por frame, el Reloj toma la
+ hora UNA vez al comienzo de cada tick y la reparte en un Tick.
+ Todas las pelotas ven el mismo "ahora" y se ahorran miles de
+ lecturas del reloj del sistema con muchas pelotas.
+
+ La hora sale de una FuenteTiempo:
+   - RelojReal:    el reloj de openFrameworks (tiempo real).
+   - RelojVirtual: avanza un paso fijo por tick, sin mirar el reloj
+                   del sistema. Sirve para pruebas y para renderizar
+                   offline más rápido (o más lento) que el tiempo real,
+                   con los mismos tiempos de muerte y renacimiento.
+--------------------------------------------------------------
+*/
+
+// La hora de un tick, igual para todos los que la consultan
+struct Tick {
+	double segundos = 0;     // tiempo desde el arranque
+	uint64_t milis = 0;      // lo mismo en milisegundos
+	float dt = 0;            // segundos desde el tick anterior
+	uint64_t numero = 0;     // número de tick
+};
+
+class FuenteTiempo
+{
+public:
+	virtual ~FuenteTiempo() {}
+	
+	// Segundos desde el arranque
+	virtual double ahora() = 0;
+	
+	// Se llama una vez por tick, después de leer la hora
+	virtual void avanzar() {}
+};
+
+class RelojReal : public FuenteTiempo
+{
+public:
+	double ahora() { return ofGetElapsedTimeMicros() / 1000000.0; }
+};
+
+class RelojVirtual : public FuenteTiempo
+{
+public:
+	// Segundos virtuales por tick (por defecto, un frame a 60 fps)
+	void setPaso(double segundos) { paso = segundos; }
+	
+	double ahora() { return tiempo; }
+	void avanzar() { tiempo += paso; }
+	
+private:
+	double tiempo = 0;
+	double paso = 1.0 / 60.0;
+};
+
+class Reloj
+{
+public:
+	// Cambia la fuente de tiempo (no es dueño del puntero)
+	void setFuente(FuenteTiempo* f) { fuente = f; }
+	
+	// Lee la hora una vez y arma el Tick (al comienzo de cada tick)
+	const Tick& muestrear();
+	
+	// El último Tick muestreado
+	const Tick& actual() { return tick; }
+	
+private:
+	FuenteTiempo* fuente = nullptr;
+	Tick tick;
+};
@@ -0,0 +1,277 @@
+/*
+--------------------------------------------------------------
+ relojMidi.cpp
+
+ Implementación de la clase RelojMidi
+--------------------------------------------------------------
+*/
+
+#include "relojMidi.h"
+#include "azar.h"
+#include <chrono>
+
+// Abre la entrada MIDI del reloj (igual que la de Program Change)
+void RelojMidi::conectar(const string& nombre)
+{
+	if(nombre == nombreEntrada) return;
+
+	cerrar();
+
+	if(!nombre.empty() && midiIn.openPort(nombre)) {
+		midiIn.ignoreTypes(true, false, true);   // el reloj viene en los mensajes de timing
+		midiIn.addListener(this);
+		nombreEntrada = nombre;
+		conectado = true;
+		ofLogNotice() << "Reloj MIDI en el puerto " << nombre;
+	}
+}
+
+void RelojMidi::cerrar()
+{
+	if(nombreEntrada.empty()) return;
+	midiIn.removeListener(this);
+	midiIn.closePort();
+	ofLogNotice() << "Se cerró la entrada del reloj MIDI " << nombreEntrada;
+	nombreEntrada = "";
+	conectado = false;
+}
+
+double RelojMidi::ahora()
+{
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Hilo MIDI: la hora se toma apenas llega el mensaje
+void RelojMidi::newMidiMessage(ofxMidiMessage& mensaje)
+{
+	recibir(mensaje, ahora());
+}
+
+/*
+--------------------------------------------------------------
+ recibir(mensaje, segundos)
+ - Clock: un pulso más para el filtro, y para la posición si corre
+ - Start: posición a cero y a correr (cuenta un inicio)
+ - Continue: sigue desde donde estaba
+ - Stop: la posición queda quieta; el tempo se sigue filtrando
+ - Song Position: en semicorcheas (6 pulsos), para el próximo pulso
+--------------------------------------------------------------
+*/
+
+void RelojMidi::recibir(const ofxMidiMessage& mensaje, double segundos)
+{
+	switch(mensaje.status) {
+		case MIDI_TIME_CLOCK:
+			pulso(segundos);
+			break;
+
+		case MIDI_START:
+			pulsosPosicion = 0;
+			corriendo = true;
+			inicios++;
+			break;
+
+		case MIDI_CONTINUE:
+			corriendo = true;
+			break;
+
+		case MIDI_STOP:
+			corriendo = false;
+			break;
+
+		case MIDI_SONG_POS_POINTER: {
+			int semicorcheas = mensaje.bytes.size() >= 3
+				? (mensaje.bytes[2] << 7) | mensaje.bytes[1]
+				: mensaje.value;
+			pulsosPosicion = (int64_t)semicorcheas * 6;
+			break;
+		}
+
+		default:
+			return;
+	}
+	publicar();
+}
+
+/*
+--------------------------------------------------------------
+ pulso(t)
+ DLL de segundo orden (F. Adriaensen, "Using a DLL to filter time"):
+   e  = t - t1              error de la hora prevista
+   t0 = t1,  t1 += b*e + periodo,  periodo += c*e
+ con w = 2*pi*B*periodo, b = sqrt(2)*w, c = w*w.
+ Los dos primeros pulsos dan el período inicial. Un hueco largo
+ (el secuenciador se paró o se desenchufó) reinicia el filtro.
+--------------------------------------------------------------
+*/
+
+void RelojMidi::pulso(double t)
+{
+	if(ultimoPulsoCrudo >= 0 && t - ultimoPulsoCrudo > SEGUNDOS_SIN_PULSOS)
+		reiniciarFiltro();
+
+	if(pulsosFiltro == 0)
+		t1 = t;
+	else if(pulsosFiltro == 1) {
+		periodo = t - t0;
+		t1 = t + periodo;
+	}
+	else {
+		double banda = pulsosFiltro < 4 * PULSOS_POR_NEGRA ? BANDA_ENGANCHE : BANDA_SEGUIMIENTO;
+		double w = TWO_PI * banda * periodo;
+		double e = t - t1;
+		t1 += sqrt(2.0) * w * e + periodo;
+		periodo += w * w * e;
+		// entre 20 y 300 bpm
+		periodo = max(60.0 / (300 * PULSOS_POR_NEGRA), min(periodo, 60.0 / (20 * PULSOS_POR_NEGRA)));
+	}
+
+	if(pulsosFiltro < 2) t0 = t;
+	else t0 = t1 - periodo;   // hora filtrada de este pulso
+	pulsosFiltro++;
+	ultimoPulsoCrudo = t;
+
+	if(corriendo) pulsosPosicion++;
+}
+
+void RelojMidi::reiniciarFiltro()
+{
+	pulsosFiltro = 0;
+	ultimoPulsoCrudo = -1;
+}
+
+// Escritor único (hilo MIDI): secuencia impar mientras escribe
+void RelojMidi::publicar()
+{
+	secuencia.fetch_add(1);
+	pubPulso = t0;
+	pubPeriodo = periodo;
+	pubPosicion = pulsosPosicion;
+	pubPulsosFiltro = pulsosFiltro;
+	pubCorriendo = corriendo;
+	secuencia.fetch_add(1);
+}
+
+EstadoRelojMidi RelojMidi::leer()
+{
+	return leer(ahora());
+}
+
+EstadoRelojMidi RelojMidi::leer(double segundos)
+{
+	double ultimo, per;
+	int64_t posicion;
+	int filtrados;
+	bool corre;
+	uint32_t s;
+	do {
+		s = secuencia.load();
+		ultimo = pubPulso;
+		per = pubPeriodo;
+		posicion = pubPosicion;
+		filtrados = pubPulsosFiltro;
+		corre = pubCorriendo;
+	} while((s & 1) || s != secuencia.load());
+
+	EstadoRelojMidi estado;
+	estado.inicios = inicios;
+	if(filtrados < 2 || per <= 0) return estado;
+
+	estado.bpm = 60.0 / (per * PULSOS_POR_NEGRA);
+	bool reciente = segundos - ultimo < SEGUNDOS_SIN_PULSOS;
+	estado.enganchado = reciente && corre && filtrados >= PULSOS_POR_NEGRA;
+
+	// el primer pulso después del Start es la negra 0
+	if(posicion > 0) {
+		double fraccion = corre ? max(0.0, min((segundos - ultimo) / per, 1.0)) : 0.0;
+		estado.negras = (posicion - 1 + fraccion) / PULSOS_POR_NEGRA;
+	}
+	return estado;
+}
+
+
+/*
+--------------------------------------------------------------
+ prueba()
+ Loopback sin puertos: arma los mensajes como los entrega ofxMidi
+ y los pasa por recibir() con horas sintéticas.
+   1. 120 bpm con jitter uniforme de ±2 ms y algún pico de 6 ms
+      (un driver USB cargado). Después de enganchar, el tempo
+      tiene que quedar a menos de 0.5 bpm y la fase a menos de 2 ms.
+   2. Salto a 140 bpm: tiene que volver a 0.5 bpm en menos de 4 s.
+   3. Song Position a la semicorchea 16 y Continue: un pulso después
+      la posición es 4 negras.
+--------------------------------------------------------------
+*/
+
+bool RelojMidi::prueba()
+{
+	RelojMidi reloj;
+	Azar azar(48);
+	ofxMidiMessage clock, start, cont, spp;
+	clock.status = MIDI_TIME_CLOCK;
+	start.status = MIDI_START;
+	cont.status = MIDI_CONTINUE;
+	spp.status = MIDI_SONG_POS_POINTER;
+	spp.bytes = { 0xF2, 16, 0 };
+
+	auto jitter = [&azar]() {
+		double j = azar.uniforme(-0.002f, 0.002f);
+		if(azar.siguiente() % 50 == 0) j += 0.006;   // de vez en cuando llega tarde
+		return j;
+	};
+
+	bool bien = true;
+	double t = 100;     // hora del pulso ideal
+	double bpm = 120;
+	reloj.recibir(start, t - 0.01);
+
+	// 1. tempo fijo: se mide desde los 4 s
+	double errorTempo = 0, errorFase = 0, sumaTempo2 = 0;
+	int medidas = 0;
+	for(int i = 0; i < 24 * 2 * 20; i++) {       // 20 s a 120 bpm
+		reloj.recibir(clock, t + jitter());
+		double negraIdeal = (double)i / PULSOS_POR_NEGRA;
+		if(t >= 104) {
+			// a mitad de camino al próximo pulso, como un frame cualquiera
+			double periodoIdeal = 60.0 / (bpm * PULSOS_POR_NEGRA);
+			EstadoRelojMidi e = reloj.leer(t + periodoIdeal / 2);
+			double fase = (e.negras - (negraIdeal + 0.5 / PULSOS_POR_NEGRA)) * 60.0 / bpm;
+			errorTempo = max(errorTempo, fabs(e.bpm - bpm));
+			sumaTempo2 += (e.bpm - bpm) * (e.bpm - bpm);
+			errorFase = max(errorFase, fabs(fase));
+			medidas++;
+			if(!e.enganchado) bien = false;
+		}
+		t += 60.0 / (bpm * PULSOS_POR_NEGRA);
+	}
+	ofLogNotice("RelojMidi") << "120 bpm, jitter ±2 ms: tempo " << ofToString(errorTempo, 3) << " bpm máx, "
+							 << ofToString(sqrt(sumaTempo2 / medidas), 3) << " rms; fase "
+							 << ofToString(errorFase * 1000, 2) << " ms máx";
+	if(errorTempo > 0.5 || errorFase > 0.002) bien = false;
+
+	// 2. salto de tempo
+	bpm = 140;
+	double salto = t, enganche = -1;
+	while(t - salto < 10) {
+		reloj.recibir(clock, t + jitter());
+		double error = fabs(reloj.leer(t).bpm - bpm);
+		if(error > 0.5) enganche = -1;
+		else if(enganche < 0) enganche = t - salto;
+		t += 60.0 / (bpm * PULSOS_POR_NEGRA);
+	}
+	ofLogNotice("RelojMidi") << "120 -> 140 bpm: " << ofToString(enganche, 2) << " s para quedar a menos de 0.5 bpm";
+	if(enganche < 0 || enganche > 4) bien = false;
+
+	// 3. Song Position
+	reloj.recibir(spp, t - 0.001);
+	reloj.recibir(cont, t - 0.0005);
+	reloj.recibir(clock, t);
+	double negras = reloj.leer(t).negras;
+	ofLogNotice("RelojMidi") << "Song Position 16: " << ofToString(negras, 3) << " negras (esperado 4)";
+	if(fabs(negras - 4) > 0.01) bien = false;
+
+	ofLogNotice("RelojMidi") << (bien ? "bien" : "FALLA");
+	return bien;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "ofMain.h"
+#include "ofxMidi.h"
+#include <atomic>
+
+/*
+--------------------------------------------------------------
+ relojMidi.h
+
+ Clase RelojMidi
+
+ Sigue el reloj MIDI de un secuenciador o una caja de ritmos
+ (24 pulsos por negra, Start, Stop, Continue y Song Position)
+ para que la simulación vaya a su tempo.
+
+   - Los mensajes llegan por el callback de ofxMidiIn, en el hilo
+     propio de la entrada MIDI. Ahí mismo se filtra cada pulso:
+     un DLL (lazo de seguimiento de segundo orden) estima el período
+     y la hora "limpia" del pulso, sin el jitter del cable, del driver
+     ni del scheduler. Son unas pocas sumas por pulso.
+   - El resultado se publica con un contador de secuencia: leer()
+     toma una copia coherente sin bloquear al hilo MIDI. El hilo del
+     GUI la lee una vez por frame; no paga nada por cada mensaje.
+   - Con el reloj enganchado, leer() extrapola la posición en negras
+     a la hora de la lectura, entre pulso y pulso.
+
+ ofApp lo usa para llevar la velocidad de la simulación, la dulce
+ espera y la vida de las pelotas a negras (ver README, "Reloj MIDI").
+ --test-reloj-midi pasa un reloj sintético con jitter por el mismo
+ camino que los mensajes reales y mide el error del tempo y la fase.
+--------------------------------------------------------------
+*/
+
+// Copia del estado del reloj en un instante
+struct EstadoRelojMidi {
+	bool enganchado = false;   // hay pulsos recientes, el filtro ya convergió y el transporte corre
+	double bpm = 120;          // tempo filtrado
+	double negras = 0;         // posición desde el Start (o Song Position), en negras
+	uint32_t inicios = 0;      // cuántos Start llegaron (para ver si hubo uno nuevo)
+};
+
+class RelojMidi : public ofxMidiListener
+{
+public:
+	static const int PULSOS_POR_NEGRA = 24;
+	static constexpr double BPM_REFERENCIA = 120;   // a este tempo la simulación va a su velocidad de siempre
+
+	// Escucha el reloj en el puerto MIDI de entrada con ese nombre.
+	// Como BancoPresets::conectarEntradaMidi: se puede volver a llamar
+	// cuando cambian los puertos. "" = no hay puerto.
+	void conectar(const string& nombre);
+	void cerrar();
+
+	// Estado a esta hora (cualquier hilo, sin bloqueo)
+	EstadoRelojMidi leer();
+
+	bool estaConectado() { return conectado; }
+
+	// Callback de ofxMidi (hilo MIDI)
+	void newMidiMessage(ofxMidiMessage& mensaje);
+
+	// --test-reloj-midi: reloj sintético con jitter, true si el filtro lo sigue
+	static bool prueba();
+
+private:
+	// Procesa un mensaje como si hubiera llegado a esa hora (segundos)
+	void recibir(const ofxMidiMessage& mensaje, double segundos);
+	void pulso(double t);
+	EstadoRelojMidi leer(double segundos);
+	void reiniciarFiltro();
+	static double ahora();
+
+	// Ancho de banda del DLL: ancho para enganchar rápido, angosto después
+	static constexpr double BANDA_ENGANCHE = 2.0;    // Hz
+	static constexpr double BANDA_SEGUIMIENTO = 0.5; // Hz
+	static constexpr double SEGUNDOS_SIN_PULSOS = 0.5; // más que esto sin pulsos: se suelta
+
+	ofxMidiIn midiIn;
+	string nombreEntrada;
+	std::atomic<bool> conectado{false};
+
+	// Estado del filtro (solo el hilo MIDI)
+	double t0 = 0, t1 = 0;      // hora filtrada del último pulso y la prevista del próximo
+	double periodo = 0;         // segundos por pulso
+	double ultimoPulsoCrudo = -1;
+	int pulsosFiltro = 0;       // pulsos desde que se reinició el filtro
+	int64_t pulsosPosicion = 0; // pulsos desde el Start o la Song Position
+	bool corriendo = true;      // sin Start ni Stop, un reloj solo también vale
+
+	// Lo publicado para los lectores (escribe el hilo MIDI)
+	std::atomic<uint32_t> secuencia{0};
+	std::atomic<double> pubPulso{0};      // hora filtrada del último pulso
+	std::atomic<double> pubPeriodo{0};
+	std::atomic<int64_t> pubPosicion{0};
+	std::atomic<int> pubPulsosFiltro{0};
+	std::atomic<bool> pubCorriendo{true};
+	std::atomic<uint32_t> inicios{0};
+
+	void publicar();
+};
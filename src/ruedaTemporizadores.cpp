@@ -0,0 +1,131 @@
+/*
+--------------------------------------------------------------
+ ruedaTemporizadores.cpp
+
+ Implementación de la clase RuedaTemporizadores
+--------------------------------------------------------------
+*/
+
+#include "ruedaTemporizadores.h"
+
+void RuedaTemporizadores::setup(int capacidad, uint64_t tickActual)
+{
+	nodos.clear();
+	nodos.reserve(capacidad);
+	actual = tickActual;
+	vaciar();
+}
+
+void RuedaTemporizadores::vaciar()
+{
+	for(int n = 0; n < NIVELES; n++)
+		for(int r = 0; r < RANURAS; r++)
+			ranuras[n][r] = -1;
+	lejanos = -1;
+	
+	libres = -1;
+	for(int i = (int)nodos.size() - 1; i >= 0; i--) {
+		nodos[i].siguiente = libres;
+		libres = i;
+	}
+	cantidad = 0;
+}
+
+void RuedaTemporizadores::programar(uint64_t vence, const EventoRueda& evento)
+{
+	int nodo = libres;
+	if(nodo >= 0)
+		libres = nodos[nodo].siguiente;
+	else {
+		// pasó la capacidad: crece (es lo único que reserva memoria)
+		nodo = nodos.size();
+		nodos.push_back(Nodo());
+	}
+	
+	nodos[nodo].evento = evento;
+	nodos[nodo].evento.vence = max(vence, actual + 1);
+	ubicar(nodo);
+	cantidad++;
+}
+
+/*
+--------------------------------------------------------------
+ ubicar(nodo)
+ Elige la rueda según cuánto falta: la más baja cuyo alcance
+ (64, 64^2, ... ticks) lo cubre, y la ranura según los bits del
+ tick de vencimiento que le corresponden a esa rueda.
+--------------------------------------------------------------
+*/
+
+void RuedaTemporizadores::ubicar(int nodo)
+{
+	uint64_t vence = nodos[nodo].evento.vence;
+	uint64_t falta = vence - actual;
+	
+	for(int nivel = 0; nivel < NIVELES; nivel++) {
+		if(falta < (1ull << (BITS * (nivel + 1)))) {
+			int r = (vence >> (BITS * nivel)) & (RANURAS - 1);
+			nodos[nodo].siguiente = ranuras[nivel][r];
+			ranuras[nivel][r] = nodo;
+			return;
+		}
+	}
+	nodos[nodo].siguiente = lejanos;
+	lejanos = nodo;
+}
+
+// Vuelve a ubicar los eventos de la ranura actual de una rueda
+void RuedaTemporizadores::bajar(int nivel)
+{
+	int* lista;
+	if(nivel < NIVELES) {
+		int r = (actual >> (BITS * nivel)) & (RANURAS - 1);
+		lista = &ranuras[nivel][r];
+	}
+	else
+		lista = &lejanos;
+	
+	int nodo = *lista;
+	*lista = -1;
+	while(nodo >= 0) {
+		int siguiente = nodos[nodo].siguiente;
+		ubicar(nodo);
+		nodo = siguiente;
+	}
+}
+
+/*
+--------------------------------------------------------------
+ avanzar(tick, vencidos)
+ Tick por tick: si la rueda 0 empieza una vuelta, primero se bajan
+ las ranuras de las ruedas de arriba (de la más alta a la más baja),
+ y después salen los eventos de la ranura del tick.
+--------------------------------------------------------------
+*/
+
+void RuedaTemporizadores::avanzar(uint64_t tick, vector<EventoRueda>& vencidos)
+{
+	while(actual < tick) {
+		actual++;
+		
+		if((actual & (RANURAS - 1)) == 0) {
+			int hasta = 1;
+			while(hasta < NIVELES && ((actual >> (BITS * hasta)) & (RANURAS - 1)) == 0)
+				hasta++;
+			for(int nivel = hasta; nivel >= 1; nivel--)
+				bajar(nivel);
+		}
+		
+		int& ranura = ranuras[0][actual & (RANURAS - 1)];
+		int nodo = ranura;
+		ranura = -1;
+		while(nodo >= 0) {
+			int siguiente = nodos[nodo].siguiente;
+			vencidos.push_back(nodos[nodo].evento);
+			nodos[nodo].siguiente = libres;
+			libres = nodo;
+			cantidad--;
+			nodo = siguiente;
+		}
+	}
+}
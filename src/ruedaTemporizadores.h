@@ -0,0 +1,81 @@
+#pragma once
+#include "ofMain.h"
+#include "poolPelotas.h"
+
+/*
+--------------------------------------------------------------
+ ruedaTemporizadores.h
+
+ Clase RuedaTemporizadores
+
+ Agenda de eventos por número de tick (muertes de pelotas,
+ regeneración), para no revisar todas las pelotas en cada tick
+ preguntando si ya les tocó. Es una rueda jerárquica:
+
+   - NIVELES ruedas de RANURAS ranuras. La rueda 0 tiene un tick por
+     ranura; cada ranura de la rueda 1 abarca una vuelta entera de la
+     rueda 0 (64 ticks), y así siguiendo: 64^4 ticks (más de 3 días a
+     60 fps). Lo que vence más lejos espera en una lista aparte.
+   - Cada vez que la rueda 0 completa una vuelta, la ranura que toca
+     de la rueda de arriba se "baja": sus eventos se vuelven a ubicar
+     en la rueda de abajo.
+   - avanzar() cuesta lo que cuestan los eventos que vencen (y las
+     bajadas), no lo que cuesta revisar toda la población.
+   - Los eventos viven en un arreglo reservado de antemano, enlazados
+     por índice; no se reserva memoria mientras no se pase la capacidad.
+
+ No hay cancelación: un evento de una pelota que ya no existe llega
+ con un ManejadorPelota vencido, y quien lo recibe lo ignora.
+--------------------------------------------------------------
+*/
+
+enum TipoEventoRueda : uint8_t {
+	EVENTO_MUERTE,          // termina la vida de la pelota
+	EVENTO_REGENERACION     // nace una nueva generación (si pasó la dulce espera)
+};
+
+struct EventoRueda {
+	TipoEventoRueda tipo;
+	ManejadorPelota pelota;   // EVENTO_MUERTE
+	uint64_t dato = 0;        // EVENTO_REGENERACION: generación que lo pidió
+	uint64_t vence = 0;       // tick en que se dispara (lo completa programar)
+};
+
+class RuedaTemporizadores
+{
+public:
+	static const int NIVELES = 4;
+	static const int BITS = 6;
+	static const int RANURAS = 1 << BITS;
+	
+	// Reserva lugar para "capacidad" eventos y fija el tick actual
+	void setup(int capacidad, uint64_t tickActual);
+	
+	// Agenda un evento para el tick "vence" (si ya pasó, sale en el próximo)
+	void programar(uint64_t vence, const EventoRueda& evento);
+	
+	// Avanza hasta el tick "tick" y agrega a "vencidos" los eventos que vencieron
+	void avanzar(uint64_t tick, vector<EventoRueda>& vencidos);
+	
+	// Borra todos los eventos
+	void vaciar();
+	
+	int size() { return cantidad; }
+	uint64_t getTick() { return actual; }
+	
+private:
+	struct Nodo {
+		EventoRueda evento;
+		int siguiente;
+	};
+	
+	void ubicar(int nodo);
+	void bajar(int nivel);
+	
+	vector<Nodo> nodos;
+	int libres = -1;                              // lista de nodos libres
+	int ranuras[NIVELES][RANURAS];                // primer nodo de cada ranura, -1 = vacía
+	int lejanos = -1;                             // más allá de la última rueda
+	uint64_t actual = 0;
+	int cantidad = 0;
+};
@@ -0,0 +1,293 @@
+/*
+--------------------------------------------------------------
+ sintetizador.cpp
+
+ Implementación de la clase Sintetizador
+--------------------------------------------------------------
+*/
+
+#include "sintetizador.h"
+#include "azar.h"
+#include <fstream>
+#include <cfloat>
+
+void Sintetizador::setup(int frecuenciaMuestreo)
+{
+	frecuencia = frecuenciaMuestreo;
+	for(int v = 0; v < MAX_VOCES; v++) {
+		nivel[v] = 0;
+		paso[v] = 0;
+		notaVoz[v] = -1;
+	}
+	setEnvolvente(0.01f, 0.1f);
+}
+
+// Por debajo de 2 ms la envolvente hace click
+void Sintetizador::setEnvolvente(float segundosAtaque, float segundosRelease)
+{
+	pasoAtaqueActual  = 1.0f / (max(segundosAtaque, 0.002f) * frecuencia);
+	pasoReleaseActual = 1.0f / (max(segundosRelease, 0.002f) * frecuencia);
+}
+
+void Sintetizador::noteOn(int nota, int velocidad)
+{
+	encolar({ EVENTO_ON, (uint8_t)nota, (uint8_t)velocidad, pasoAtaqueActual, pasoReleaseActual });
+}
+
+void Sintetizador::noteOff(int nota)
+{
+	encolar({ EVENTO_OFF, (uint8_t)nota, 0, 0, 0 });
+}
+
+void Sintetizador::todasOff()
+{
+	encolar({ EVENTO_TODAS_OFF, 0, 0, 0, 1.0f / (0.005f * frecuencia) });
+}
+
+void Sintetizador::encolar(const Evento& e)
+{
+	uint32_t f = fin.load(std::memory_order_relaxed);
+	if(f - cabeza.load(std::memory_order_acquire) >= CAPACIDAD) {
+		perdidos++;
+		return;
+	}
+	cola[f & (CAPACIDAD - 1)] = e;
+	fin.store(f + 1, std::memory_order_release);
+}
+
+/*
+--------------------------------------------------------------
+ procesarEventos()
+ Al comienzo de cada bloque, en el hilo de audio.
+--------------------------------------------------------------
+*/
+
+void Sintetizador::procesarEventos()
+{
+	uint32_t c = cabeza.load(std::memory_order_relaxed);
+	uint32_t f = fin.load(std::memory_order_acquire);
+	
+	for(; c != f; c++) {
+		const Evento& e = cola[c & (CAPACIDAD - 1)];
+		switch(e.tipo) {
+			case EVENTO_ON:
+				empezarNota(e);
+				break;
+			case EVENTO_OFF:
+				for(int v = 0; v < MAX_VOCES; v++)
+					if(notaVoz[v] == e.nota && paso[v] > 0)
+						paso[v] = -pasoRelease[v];
+				break;
+			case EVENTO_TODAS_OFF:
+				for(int v = 0; v < MAX_VOCES; v++)
+					if(nivel[v] > 0 || paso[v] > 0)
+						paso[v] = -e.pasoRelease;
+				break;
+		}
+	}
+	cabeza.store(c, std::memory_order_release);
+}
+
+/*
+--------------------------------------------------------------
+ empezarNota()
+ Elige la voz: la que ya tiene esa nota, o una callada, o si están
+ todas ocupadas, la más baja (prefiriendo las que se están apagando).
+--------------------------------------------------------------
+*/
+
+void Sintetizador::empezarNota(const Evento& e)
+{
+	int elegida = -1;
+	for(int v = 0; v < MAX_VOCES && elegida < 0; v++)
+		if(notaVoz[v] == e.nota && (nivel[v] > 0 || paso[v] > 0)) elegida = v;
+	
+	for(int v = 0; v < MAX_VOCES && elegida < 0; v++)
+		if(nivel[v] <= 0 && paso[v] <= 0) elegida = v;
+	
+	if(elegida < 0) {
+		float menor = FLT_MAX;   // una sostenida arriba pesa 2: siempre alguna queda elegida
+		for(int v = 0; v < MAX_VOCES; v++) {
+			float peso = nivel[v] + (paso[v] > 0 ? 1 : 0);   // las que suenan sostenidas, al final
+			if(peso < menor) { menor = peso; elegida = v; }
+		}
+		robadas++;
+	}
+	
+	int v = elegida;
+	notaVoz[v] = e.nota;
+	incremento[v] = 440.0f * powf(2.0f, (e.nota - 69) / 12.0f) / frecuencia;
+	amplitud[v] = e.velocidad / 127.0f;
+	paso[v] = e.pasoAtaque;
+	pasoRelease[v] = e.pasoRelease;
+}
+
+/*
+--------------------------------------------------------------
+ render(salida, cantidad, canales)
+ Para cada sample avanza todas las voces juntas. Los dos lazos sobre
+ las voces no tienen saltos (los recortes son min/max), así que se
+ vectorizan; la suma se hace en árbol para no depender de reordenar
+ sumas de punto flotante.
+--------------------------------------------------------------
+*/
+
+void Sintetizador::render(float* salida, int cantidad, int canales)
+{
+	procesarEventos();
+	
+	int activas = 0;
+	for(int v = 0; v < MAX_VOCES; v++)
+		if(nivel[v] > 0 || paso[v] > 0) activas++;
+	vocesActivas = activas;
+	
+	if(activas == 0) {
+		memset(salida, 0, sizeof(float) * cantidad * canales);
+		return;
+	}
+	
+	for(int i = 0; i < cantidad; i++) {
+		for(int v = 0; v < MAX_VOCES; v++) {
+			float f = fase[v] + incremento[v];
+			f -= (int)f;                      // vuelve a [0, 1)
+			fase[v] = f;
+			
+			float e = nivel[v] + paso[v];
+			e = e < 0.0f ? 0.0f : e;
+			e = e > 1.0f ? 1.0f : e;
+			nivel[v] = e;
+			
+			// seno aproximado con dos parábolas, x en [-1, 1)
+			float x = 2.0f * f - 1.0f;
+			float s = 4.0f * x * (1.0f - std::abs(x));
+			mezcla[v] = s * e * amplitud[v];
+		}
+		for(int ancho = MAX_VOCES / 2; ancho > 0; ancho /= 2)
+			for(int v = 0; v < ancho; v++)
+				mezcla[v] += mezcla[v + ancho];
+		
+		float muestra = mezcla[0] * ganancia;
+		for(int c = 0; c < canales; c++)
+			salida[i * canales + c] = muestra;
+	}
+}
+
+/*
+--------------------------------------------------------------
+ renderizarWav(ruta, segundos, semilla)
+ Prueba sin tiempo real: un arpegio al azar (reproducible con la
+ semilla), una nota cada 125 ms que se suelta a los 60 ms, pasado
+ por el mismo camino que el callback (cola + bloques de 128).
+ Se guarda en WAV estéreo de 16 bits a 44100 Hz.
+--------------------------------------------------------------
+*/
+
+static void escribir16(std::ofstream& archivo, uint16_t valor) { archivo.write((const char*)&valor, 2); }
+static void escribir32(std::ofstream& archivo, uint32_t valor) { archivo.write((const char*)&valor, 4); }
+
+bool Sintetizador::renderizarWav(const string& ruta, float segundos, uint64_t semilla)
+{
+	const int frecuenciaWav = 44100;
+	const int canales = 2;
+	const int bloque = 128;
+	
+	auto sinte = std::make_unique<Sintetizador>();
+	sinte->setup(frecuenciaWav);
+	sinte->setEnvolvente(0.02f, 0.4f);
+	
+	Azar azar = Azar::flujo(semilla, 0);
+	const int escala[] = {0, 2, 4, 5, 7, 9, 11};
+	
+	int totalBloques = (int)(segundos * frecuenciaWav / bloque);
+	vector<float> audio(totalBloques * bloque * canales);
+	vector<int16_t> pcm(audio.size());
+	
+	int proximaNota = 0;   // en samples
+	int notaSonando = -1;
+	int soltar = 0;
+	for(int b = 0; b < totalBloques; b++) {
+		int inicio = b * bloque;
+		if(notaSonando >= 0 && inicio >= soltar) {
+			sinte->noteOff(notaSonando);
+			notaSonando = -1;
+		}
+		if(inicio >= proximaNota) {
+			int grado = (int)azar.uniforme(0, 7);
+			int octava = (int)azar.uniforme(0, 4);
+			notaSonando = 36 + octava * 12 + escala[grado];
+			sinte->noteOn(notaSonando, 100);
+			soltar = inicio + frecuenciaWav * 60 / 1000;
+			proximaNota = inicio + frecuenciaWav * 125 / 1000;
+		}
+		sinte->render(audio.data() + inicio * canales, bloque, canales);
+	}
+	
+	for(size_t i = 0; i < audio.size(); i++)
+		pcm[i] = (int16_t)(ofClamp(audio[i], -1.0f, 1.0f) * 32767.0f);
+	
+	std::ofstream archivo(ruta, std::ios::binary);
+	if(!archivo) {
+		ofLogError("Sintetizador") << "No se pudo escribir " << ruta;
+		return false;
+	}
+	uint32_t bytesDatos = pcm.size() * sizeof(int16_t);
+	archivo.write("RIFF", 4);
+	escribir32(archivo, 36 + bytesDatos);
+	archivo.write("WAVEfmt ", 8);
+	escribir32(archivo, 16);                              // tamaño del bloque fmt
+	escribir16(archivo, 1);                               // PCM
+	escribir16(archivo, canales);
+	escribir32(archivo, frecuenciaWav);
+	escribir32(archivo, frecuenciaWav * canales * 2);     // bytes por segundo
+	escribir16(archivo, canales * 2);                     // bytes por frame
+	escribir16(archivo, 16);                              // bits por sample
+	archivo.write("data", 4);
+	escribir32(archivo, bytesDatos);
+	archivo.write((const char*)pcm.data(), bytesDatos);
+	
+	ofLogNotice("Sintetizador") << "WAV de prueba: " << ruta << " (" << segundos << " s, "
+								<< sinte->getRobadas() << " voces robadas)";
+	return true;
+}
+
+/*
+--------------------------------------------------------------
+ pruebaVoces()
+ Llena todas las voces con notas sostenidas (la envolvente ya
+ arriba) y pide una más: tiene que robar una voz, y la nota
+ nueva tiene que quedar en alguna.
+--------------------------------------------------------------
+*/
+
+bool Sintetizador::pruebaVoces()
+{
+	const int bloque = 128;
+	auto sinte = std::make_unique<Sintetizador>();
+	sinte->setup(44100);
+	sinte->setEnvolvente(0.002f, 0.1f);
+	vector<float> audio(bloque * 2);
+	
+	for(int v = 0; v < MAX_VOCES; v++)
+		sinte->noteOn(40 + v, 100);
+	for(int b = 0; b < 4; b++)          // 512 samples: el ataque dura 88
+		sinte->render(audio.data(), bloque, 2);
+	
+	int sostenidas = 0;
+	for(int v = 0; v < MAX_VOCES; v++)
+		if(sinte->nivel[v] >= 1.0f && sinte->paso[v] > 0) sostenidas++;
+	
+	int notaNueva = 40 + MAX_VOCES;
+	sinte->noteOn(notaNueva, 100);
+	sinte->render(audio.data(), bloque, 2);
+	
+	int conNotaNueva = 0;
+	for(int v = 0; v < MAX_VOCES; v++)
+		if(sinte->notaVoz[v] == notaNueva) conNotaNueva++;
+	
+	bool bien = sostenidas == MAX_VOCES && sinte->getRobadas() == 1 &&
+				conNotaNueva == 1 && sinte->getVocesActivas() == MAX_VOCES;
+	ofLogNotice("Sintetizador") << "voces: " << sostenidas << " de " << (int)MAX_VOCES << " sostenidas, "
+								<< sinte->getRobadas() << " robada, nota nueva en " << conNotaNueva
+								<< " voz: " << (bien ? "bien" : "FALLA");
+	return bien;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "ofMain.h"
+
+/*
+--------------------------------------------------------------
+ sintetizador.h
+
+ Clase Sintetizador
+
+ Sintetizador polifónico interno, para escuchar las pelotas sin pasar
+ por MIDI, Ableton y un instrumento virtual (y sin su latencia).
+
+   - MAX_VOCES voces reservadas de antemano, guardadas como arreglos
+     separados (fase, incremento, nivel, ...): el cálculo de un sample
+     recorre todas las voces con las mismas operaciones, sin saltos,
+     y el compilador lo hace con instrucciones SIMD.
+   - Cada voz es un oscilador (seno aproximado por parábolas) con una
+     envolvente lineal: sube en "ataque" segundos, se sostiene mientras
+     la nota está apretada y baja en "release" segundos.
+   - Las notas llegan por una cola sin bloqueo: noteOn/noteOff los llama
+     el tick de simulación (un solo productor a la vez) y el callback de
+     audio los lee al comienzo de cada bloque. El callback no bloquea
+     ni reserva memoria.
+   - renderizarWav() genera una secuencia de prueba sin ventana ni
+     placa de sonido y la guarda en un WAV.
+
+ La latencia entre el rebote y el sonido es la del tick más la del
+ bloque de audio (128 samples a 44100 Hz = 2.9 ms) más la del driver.
+--------------------------------------------------------------
+*/
+
+class Sintetizador
+{
+public:
+	static const int MAX_VOCES = 32;
+	
+	void setup(int frecuenciaMuestreo);
+	
+	// Ataque y release en segundos, para las notas que empiezan desde ahora (productor)
+	void setEnvolvente(float segundosAtaque, float segundosRelease);
+	
+	// Eventos de nota (productor: tick de simulación)
+	void noteOn(int nota, int velocidad);
+	void noteOff(int nota);
+	void todasOff();
+	
+	// Llena un bloque intercalado de "canales" canales (callback de audio)
+	void render(float* salida, int cantidad, int canales);
+	
+	// Voces sonando, según el último bloque
+	int getVocesActivas()      { return vocesActivas.load(); }
+	uint64_t getRobadas()      { return robadas.load(); }    // notas que tomaron una voz ocupada
+	uint64_t getPerdidos()     { return perdidos.load(); }   // eventos que no entraron en la cola
+	
+	// Secuencia de prueba reproducible, renderizada sin tiempo real a un WAV
+	static bool renderizarWav(const string& ruta, float segundos, uint64_t semilla);
+	
+	// --test-voces: todas las voces sostenidas y una nota más. true si roba una sola voz.
+	static bool pruebaVoces();
+	
+	float ganancia = 0.15f;
+	
+private:
+	enum TipoEvento : uint8_t { EVENTO_ON, EVENTO_OFF, EVENTO_TODAS_OFF };
+	
+	struct Evento {
+		TipoEvento tipo;
+		uint8_t nota;
+		uint8_t velocidad;
+		float pasoAtaque;    // nivel por sample
+		float pasoRelease;
+	};
+	
+	void encolar(const Evento& e);
+	void procesarEventos();
+	void empezarNota(const Evento& e);
+	
+	// Cola de eventos (un productor, un consumidor)
+	static const uint32_t CAPACIDAD = 256;    // potencia de 2
+	Evento cola[CAPACIDAD];
+	std::atomic<uint32_t> cabeza{0};   // próximo a leer (audio)
+	std::atomic<uint32_t> fin{0};      // próximo a escribir (productor)
+	
+	// Estado de las voces, un arreglo por variable (solo el hilo de audio)
+	alignas(32) float fase[MAX_VOCES] = {0};
+	alignas(32) float incremento[MAX_VOCES] = {0};
+	alignas(32) float amplitud[MAX_VOCES] = {0};
+	alignas(32) float nivel[MAX_VOCES] = {0};
+	alignas(32) float paso[MAX_VOCES] = {0};        // > 0 sube/sostiene, < 0 baja
+	alignas(32) float pasoRelease[MAX_VOCES] = {0};
+	alignas(32) float mezcla[MAX_VOCES];             // aporte de cada voz al sample actual
+	int notaVoz[MAX_VOCES];
+	
+	float frecuencia = 44100;
+	float pasoAtaqueActual = 1.0f / 441.0f;     // productor
+	float pasoReleaseActual = 1.0f / 4410.0f;
+	
+	std::atomic<int> vocesActivas{0};
+	std::atomic<uint64_t> robadas{0};
+	std::atomic<uint64_t> perdidos{0};
+};
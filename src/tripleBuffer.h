@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+
+/*
+--------------------------------------------------------------
+ tripleBuffer.h
+
+ Clase TripleBuffer<T>
+
+ Pasa datos de un hilo productor a un hilo consumidor sin mutex.
+ Hay tres copias de T:
+ 
+   - una donde escribe el productor,
+   - una que lee el consumidor,
+   - y una intermedia que se intercambia atómicamente.
+
+ El productor escribe en escritura() y llama a publicar().
+ El consumidor llama a lectura() y recibe siempre la última copia
+ publicada completa. Ninguno espera al otro: si el productor publica
+ dos veces antes de que el consumidor lea, la más vieja se pisa.
+--------------------------------------------------------------
+*/
+
+template<class T>
+class TripleBuffer
+{
+public:
+	// Copia un valor inicial en las tres copias (para reservar memoria antes de usarlas)
+	void inicializar(const T& valor) {
+		for(int i = 0; i < 3; i++) buffers[i] = valor;
+	}
+	
+	// Productor: copia donde escribir el próximo estado
+	T& escritura() { return buffers[indiceEscritura]; }
+	
+	// Productor: entrega la copia escrita y toma la intermedia para el próximo estado.
+	// Devuelve true si la copia publicada anterior se pisó sin que nadie la leyera.
+	bool publicar() {
+		int anterior = intermedio.exchange(indiceEscritura | NUEVO, std::memory_order_acq_rel);
+		indiceEscritura = anterior & INDICE;
+		return anterior & NUEVO;
+	}
+	
+	// Consumidor: la última copia publicada
+	const T& lectura() {
+		if(intermedio.load(std::memory_order_relaxed) & NUEVO) {
+			int anterior = intermedio.exchange(indiceLectura, std::memory_order_acq_rel);
+			indiceLectura = anterior & INDICE;
+		}
+		return buffers[indiceLectura];
+	}
+	
+	// Consumidor: true si hay una copia publicada que todavía no se leyó
+	bool hayNuevo() const {
+		return intermedio.load(std::memory_order_relaxed) & NUEVO;
+	}
+	
+private:
+	static const int INDICE = 3;   // bits del índice de la copia intermedia
+	static const int NUEVO = 4;    // bit "la intermedia tiene algo sin leer"
+	
+	T buffers[3];
+	std::atomic<int> intermedio{1};
+	int indiceEscritura = 0;
+	int indiceLectura = 2;
+};